@@ -0,0 +1,103 @@
+/*
+arena.c - jsonparse
+Modified 2026-10-19
+*/
+
+/* Header-specific includes. */
+#include "arena.h"
+
+/* Implementation-specific includes. */
+#include <assert.h>
+
+/* Constants. */
+#define SIZE_BLOCK 65536
+
+/* Helpers. */
+#define SIZE_ALIGN(size) \
+  (((size)+sizeof(max_align_t)-1)/sizeof(max_align_t)*sizeof(max_align_t))
+
+/*
+*** Interface.
+*/
+
+json_arena *json_arena_create(void)
+{
+  json_arena *arena = malloc(sizeof(*arena));
+  if (arena == NULL)
+    return NULL;
+  arena->block = NULL;
+  return arena;
+}
+
+void *json_arena_allocate(json_arena *arena, size_t size)
+{
+  /* Internal errors. */
+  assert(arena != NULL);
+  
+  size = SIZE_ALIGN(size > 0 ? size : 1);
+  
+  /* Serve from the current block if it has room. */
+  json_arena_block *block = arena->block;
+  if (block != NULL && block->size-block->used >= size) {
+    void *memory = (char*)block->data+block->used;
+    block->used += size;
+    return memory;
+  }
+  
+  /* Otherwise start a new block. Oversized requests get a block of their own. */
+  size_t block_size = size > SIZE_BLOCK ? size : SIZE_BLOCK;
+  block = malloc(sizeof(*block)+block_size);
+  if (block == NULL)
+    return NULL;
+  block->size = block_size;
+  block->used = size;
+  if (size > SIZE_BLOCK && arena->block != NULL) {
+    /* Keep filling the current block afterwards. */
+    block->previous = arena->block->previous;
+    arena->block->previous = block;
+  } else {
+    block->previous = arena->block;
+    arena->block = block;
+  }
+  return block->data;
+}
+
+wchar_t *json_arena_string(json_arena *arena, wchar_t *string)
+{
+  /* Internal errors. */
+  assert(arena != NULL);
+  assert(string != NULL);
+  
+  size_t size = wcslen(string)+1 /* NUL. */;
+  wchar_t *copy = json_arena_allocate(arena, size*sizeof(*copy));
+  if (copy == NULL)
+    return NULL;
+  wmemcpy(copy, string, size);
+  return copy;
+}
+
+bool json_arena_owns(json_arena *arena, const void *memory)
+{
+  /* Internal errors. */
+  assert(arena != NULL);
+  
+  const char *byte = memory;
+  for (json_arena_block *block = arena->block; block != NULL; block = block->previous)
+    if (byte >= (const char*)block->data && byte < (const char*)block->data+block->used)
+      return true;
+  return false;
+}
+
+void json_arena_destroy(json_arena *arena)
+{
+  /* Internal errors. */
+  assert(arena != NULL);
+  
+  json_arena_block *block = arena->block;
+  while (block != NULL) {
+    json_arena_block *previous = block->previous;
+    free(block);
+    block = previous;
+  }
+  free(arena);
+}
@@ -0,0 +1,37 @@
+/*
+arena.h - jsonparse
+Modified 2026-10-19
+*/
+
+#ifndef JSON_ARENA_H
+#define JSON_ARENA_H
+
+/* Header-specific includes. */
+#include "common.h"
+#include <stddef.h>
+#include <wchar.h>
+
+/*
+Arena blocks.
+*/
+
+typedef struct json_arena_block_ {
+  struct json_arena_block_ *previous;
+  size_t size;
+  size_t used;
+  max_align_t data[];
+} json_arena_block;
+
+struct json_arena_ {
+  json_arena_block *block;
+};
+
+/*
+*** Interface.
+*/
+
+#include "arena_public.h"
+
+bool json_arena_owns(json_arena *arena, const void *memory);
+
+#endif /* !JSON_ARENA_H */
@@ -0,0 +1,11 @@
+#ifndef JSON_ARENA_PUBLIC_H
+#define JSON_ARENA_PUBLIC_H
+
+typedef struct json_arena_ json_arena;
+
+json_arena *json_arena_create(void);
+void *json_arena_allocate(json_arena *arena, size_t size);
+wchar_t *json_arena_string(json_arena *arena, wchar_t *string);
+void json_arena_destroy(json_arena *arena);
+
+#endif /* !JSON_ARENA_PUBLIC_H */
@@ -0,0 +1,323 @@
+/*
+builder.c - jsonparse
+Modified 2026-10-19
+*/
+
+/* Header-specific includes. */
+#include "builder.h"
+
+/* Implementation-specific includes. */
+#include <assert.h>
+#include <string.h>
+#include <wchar.h>
+
+/* Constants. */
+#define SIZE_CONTAINER 16
+
+/*
+*** Helpers.
+*/
+
+static void *builder_resize(json_builder *builder, void *memory, size_t size_old, size_t size_new)
+{
+  if (builder->arena == NULL)
+    return realloc(memory, size_new);
+  
+  /* Arenas cannot grow in place; move to a fresh allocation. */
+  void *memory_new = json_arena_allocate(builder->arena, size_new);
+  if (memory_new != NULL && memory != NULL)
+    memcpy(memory_new, memory, size_old < size_new ? size_old : size_new);
+  return memory_new;
+}
+
+static void builder_drop(json_builder *builder, wchar_t *key, json_value value)
+{
+  /* Arena-backed values are released with the arena. */
+  if (builder->arena != NULL)
+    return;
+  free(key);
+  json_value_free(value);
+}
+
+#ifndef NDEBUG
+/*
+Whether a key and value given to a builder can be dropped by it. Those given to
+an arena builder must live in its arena; only the top level is checked.
+*/
+static bool builder_owns(json_builder *builder, wchar_t *key, json_value value)
+{
+  if (builder->arena == NULL)
+    return true;
+  if (key != NULL && !json_arena_owns(builder->arena, key))
+    return false;
+  switch (value.type) {
+    case JSON_TYPE_STRING:
+      return json_arena_owns(builder->arena, value.as.string);
+    case JSON_TYPE_ARRAY:
+      return json_arena_owns(builder->arena, value.as.array);
+    case JSON_TYPE_OBJECT:
+      return value.as.object.pairs == NULL || json_arena_owns(builder->arena, value.as.object.pairs);
+    case JSON_TYPE_INTEGER_ARRAY:
+    case JSON_TYPE_FLOATING_ARRAY:
+      return value.as.packed.items == NULL || json_arena_owns(builder->arena, value.as.packed.items);
+    case JSON_TYPE_NUMBER:
+      return json_arena_owns(builder->arena, value.as.number);
+    case JSON_TYPE_SHARED:
+      /* References cannot be released with the arena. */
+      return false;
+    default:
+      return true;
+  }
+}
+#endif
+
+/*
+Size of the storage of a container with room for capacity items, or 0 if it
+would overflow.
+*/
+static size_t builder_size(json_type type, size_t capacity)
+{
+  if (type == JSON_TYPE_ARRAY)
+    return capacity < SIZE_MAX/sizeof(json_value) ? (1+capacity)*sizeof(json_value) : 0;
+  return capacity <= SIZE_MAX/sizeof(json_pair) ? capacity*sizeof(json_pair) : 0;
+}
+
+static size_t builder_count(json_builder *builder)
+{
+  if (builder->value.type == JSON_TYPE_ARRAY)
+    return (size_t)builder->value.as.array[0].as.integer;
+  return builder->value.as.object.pair_count;
+}
+
+static bool builder_grow(json_builder *builder)
+{
+  if (builder_count(builder) < builder->capacity)
+    return true;
+  if (builder->capacity > SIZE_MAX/2)
+    return false;
+  return json_builder_reserve(builder, builder->capacity > 0 ? 2*builder->capacity : SIZE_CONTAINER);
+}
+
+/*
+*** Interface.
+*/
+
+bool json_builder_array(json_builder *builder, json_arena *arena, size_t capacity)
+{
+  /* Internal errors. */
+  assert(builder != NULL);
+  
+  *builder = (json_builder){
+    .value = {
+      .type = JSON_TYPE_ARRAY,
+      .as.array = NULL
+    },
+    .capacity = 0,
+    .arena = arena
+  };
+  size_t size = builder_size(JSON_TYPE_ARRAY, capacity);
+  if (size == 0)
+    return false;
+  builder->value.as.array = builder_resize(builder, NULL, 0, size);
+  if (builder->value.as.array == NULL)
+    return false;
+  builder->value.as.array[0] = (json_value){
+    .type = JSON_TYPE_SIZE,
+    .as.integer = 0
+  };
+  builder->capacity = capacity;
+  return true;
+}
+
+bool json_builder_object(json_builder *builder, json_arena *arena, size_t capacity)
+{
+  /* Internal errors. */
+  assert(builder != NULL);
+  
+  *builder = (json_builder){
+    .value = {
+      .type = JSON_TYPE_OBJECT,
+      .as.object = (json_object){
+        .pairs = NULL,
+        .pair_count = 0
+      }
+    },
+    .capacity = 0,
+    .arena = arena
+  };
+  size_t size = builder_size(JSON_TYPE_OBJECT, capacity > 0 ? capacity : 1);
+  if (size == 0)
+    return false;
+  builder->value.as.object.pairs = builder_resize(builder, NULL, 0, size);
+  if (builder->value.as.object.pairs == NULL)
+    return false;
+  builder->capacity = capacity > 0 ? capacity : 1;
+  return true;
+}
+
+bool json_builder_adopt(json_builder *builder, json_value value)
+{
+  /* Internal errors. */
+  assert(builder != NULL);
+  
+  /* Frozen values are copied on write; their shared children stay shared. */
+  if (value.type == JSON_TYPE_SHARED) {
+    json_value copy = json_value_clone(json_value_deref(value));
+    json_value_release(value);
+    if (copy.type == JSON_TYPE_ERROR)
+      return false;
+    value = copy;
+  }
+  /* Packed arrays grow item by item like any other. */
+  if (!json_value_unpack(&value)) {
+    json_value_free(value);
+    return false;
+  }
+  assert(JSON_ARRAY_IS_INTEGROUS(value) || JSON_OBJECT_IS_INTEGROUS(value));
+  
+  *builder = (json_builder){
+    .value = value,
+    .capacity = 0,
+    .arena = NULL
+  };
+  builder->capacity = builder_count(builder);
+  return true;
+}
+
+bool json_builder_reserve(json_builder *builder, size_t capacity)
+{
+  /* Internal errors. */
+  assert(builder != NULL);
+  
+  if (capacity <= builder->capacity)
+    return true;
+  size_t size = builder_size(builder->value.type, capacity);
+  if (size == 0)
+    return false;
+  
+  if (builder->value.type == JSON_TYPE_ARRAY) {
+    json_value *array_new = builder_resize(
+      builder,
+      builder->value.as.array,
+      builder_size(JSON_TYPE_ARRAY, builder->capacity),
+      size
+    );
+    if (array_new == NULL)
+      return false;
+    builder->value.as.array = array_new;
+  } else {
+    assert(builder->value.type == JSON_TYPE_OBJECT);
+    json_pair *pairs_new = builder_resize(
+      builder,
+      builder->value.as.object.pairs,
+      builder_size(JSON_TYPE_OBJECT, builder->capacity),
+      size
+    );
+    if (pairs_new == NULL)
+      return false;
+    builder->value.as.object.pairs = pairs_new;
+  }
+  builder->capacity = capacity;
+  return true;
+}
+
+bool json_builder_push(json_builder *builder, json_value item)
+{
+  /* Internal errors. */
+  assert(builder != NULL);
+  assert(JSON_ARRAY_IS_INTEGROUS(builder->value));
+  assert(JSON_TYPE_HAS_MEANING(item.type) && item.type != JSON_TYPE_ERROR);
+  assert(builder_owns(builder, NULL, item));
+  
+  if (!builder_grow(builder)) {
+    builder_drop(builder, NULL, item);
+    return false;
+  }
+  json_integer count = ++builder->value.as.array[0].as.integer;
+  builder->value.as.array[count] = item;
+  return true;
+}
+
+bool json_builder_append(json_builder *builder, wchar_t *key, json_value value)
+{
+  /* Internal errors. */
+  assert(builder != NULL);
+  assert(JSON_OBJECT_IS_INTEGROUS(builder->value));
+  assert(key != NULL);
+  assert(JSON_TYPE_HAS_MEANING(value.type) && value.type != JSON_TYPE_ERROR);
+  assert(builder_owns(builder, key, value));
+  
+  if (!builder_grow(builder)) {
+    builder_drop(builder, key, value);
+    return false;
+  }
+  builder->value.as.object.pairs[builder->value.as.object.pair_count++] = (json_pair){
+    .key = key,
+    .value = value
+  };
+  return true;
+}
+
+bool json_builder_set(json_builder *builder, wchar_t *key, json_value value)
+{
+  /* Internal errors. */
+  assert(builder != NULL);
+  assert(JSON_OBJECT_IS_INTEGROUS(builder->value));
+  assert(key != NULL);
+  assert(builder_owns(builder, key, value));
+  
+  /* Replace the value of an existing key. */
+  json_pair *pairs = builder->value.as.object.pairs;
+  for (size_t i=0; i<builder->value.as.object.pair_count; i++) {
+    if (wcscmp(pairs[i].key, key) != 0)
+      continue;
+    builder_drop(builder, key, pairs[i].value);
+    pairs[i].value = value;
+    return true;
+  }
+  
+  return json_builder_append(builder, key, value);
+}
+
+json_value json_builder_finish(json_builder *builder)
+{
+  /* Internal errors. */
+  assert(builder != NULL);
+  
+  json_value value = builder->value;
+  
+  /* Shrink to fit. Failing to shrink is harmless. */
+  if (builder->arena == NULL) {
+    if (value.type == JSON_TYPE_ARRAY) {
+      json_value *array_new = realloc(value.as.array, (size_t)(1+value.as.array[0].as.integer)*sizeof(*array_new));
+      if (array_new != NULL)
+        value.as.array = array_new;
+    } else if (value.as.object.pair_count > 0) {
+      json_pair *pairs_new = realloc(value.as.object.pairs, value.as.object.pair_count*sizeof(*pairs_new));
+      if (pairs_new != NULL)
+        value.as.object.pairs = pairs_new;
+    }
+  }
+  
+  /* The builder no longer owns the value. */
+  builder->value = (json_value){
+    .type = JSON_TYPE_none_,
+    .as.integer = 0
+  };
+  builder->capacity = 0;
+  return value;
+}
+
+void json_builder_discard(json_builder *builder)
+{
+  /* Internal errors. */
+  assert(builder != NULL);
+  
+  if (builder->arena == NULL && JSON_TYPE_HAS_MEANING(builder->value.type))
+    json_value_free(builder->value);
+  builder->value = (json_value){
+    .type = JSON_TYPE_none_,
+    .as.integer = 0
+  };
+  builder->capacity = 0;
+}
@@ -0,0 +1,31 @@
+/*
+builder.h - jsonparse
+Modified 2026-10-19
+*/
+
+#ifndef JSON_BUILDER_H
+#define JSON_BUILDER_H
+
+/* Header-specific includes. */
+#include "common.h"
+#include "structure.h"
+#include "arena.h"
+
+/*
+*** Interface.
+
+A builder owns one array or object under construction. Storage grows
+geometrically and is shrunk to fit by json_builder_finish. Items, keys and
+values passed to a builder become its property, even if the call fails. With an
+arena, all container storage comes from the arena; the finished value must then
+be released by destroying the arena, never by json_value_free. Keys, strings and
+containers given to an arena builder must be allocated from the same arena, as
+by json_arena_string, since the builder drops them by leaving them to the
+arena; debug builds assert this. Capacities whose storage size would overflow
+fail like allocations. json_builder_adopt continues a finished array or object;
+a frozen one is copied on write, and a packed array is unpacked.
+*/
+
+#include "builder_public.h"
+
+#endif /* !JSON_BUILDER_H */
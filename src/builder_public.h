@@ -0,0 +1,20 @@
+#ifndef JSON_BUILDER_PUBLIC_H
+#define JSON_BUILDER_PUBLIC_H
+
+typedef struct json_builder_ {
+  json_value value;
+  size_t capacity;
+  json_arena *arena;
+} json_builder;
+
+bool json_builder_array(json_builder *builder, json_arena *arena, size_t capacity);
+bool json_builder_object(json_builder *builder, json_arena *arena, size_t capacity);
+bool json_builder_adopt(json_builder *builder, json_value value);
+bool json_builder_reserve(json_builder *builder, size_t capacity);
+bool json_builder_push(json_builder *builder, json_value item);
+bool json_builder_append(json_builder *builder, wchar_t *key, json_value value);
+bool json_builder_set(json_builder *builder, wchar_t *key, json_value value);
+json_value json_builder_finish(json_builder *builder);
+void json_builder_discard(json_builder *builder);
+
+#endif /* !JSON_BUILDER_PUBLIC_H */
@@ -0,0 +1,321 @@
+/*
+document.c - jsonparse
+Modified 2026-10-19
+*/
+
+/* Header-specific includes. */
+#include "document.h"
+
+/* Implementation-specific includes. */
+#include "source.h"
+#include "tools.h"
+#include <assert.h>
+#include <string.h>
+
+/* Constants. */
+#define SIZE_TEXT 4096
+#define SIZE_CHILDREN 8
+
+/* Helpers. */
+#define VALUE_ERROR(error) \
+  ((json_value){ .type = JSON_TYPE_ERROR, .as.integer = error })
+
+/*
+*** Source map.
+*/
+
+static void document_span_free(json_span *span)
+{
+  for (size_t i=0; i<span->child_count; i++)
+    document_span_free(&span->children[i]);
+  free(span->children);
+  span->children = NULL;
+  span->child_count = 0;
+}
+
+/*
+Record the spans of the value at position and everything in it. The text has
+been validated by the parser already, so this only follows the structure.
+Returns false if memory runs out; span must then still be freed.
+*/
+static bool document_scan(const char *text, size_t length, size_t *position, size_t parent, json_span *span)
+{
+  text_skip_whitespace(text, length, position);
+  size_t start = *position;
+  *span = (json_span){
+    .offset = start-parent,
+    .length = 0,
+    .child_count = 0,
+    .children = NULL
+  };
+  if (start >= length)
+    return true;
+
+  char open = text[start];
+  if (open == '{' || open == '[') {
+    char close = open == '{' ? '}' : ']';
+    size_t child_size = 0;
+    (*position)++;
+    while (true) {
+      text_skip_whitespace(text, length, position);
+      if (*position >= length)
+        break;
+      if (text[*position] == close) {
+        (*position)++;
+        break;
+      }
+      if (text[*position] == ',') {
+        (*position)++;
+        continue;
+      }
+      /* '"key":' */
+      if (open == '{') {
+        text_skip_string(text, length, position);
+        text_skip_whitespace(text, length, position);
+        if (*position < length && text[*position] == ':')
+          (*position)++;
+      }
+      /* Ensure children are big enough. */
+      if (span->child_count >= child_size) {
+        child_size = child_size > 0 ? 2*child_size : SIZE_CHILDREN;
+        json_span *children_new = realloc(span->children, child_size*sizeof(*span->children));
+        if (children_new == NULL)
+          return false;
+        span->children = children_new;
+      }
+      json_span *child = &span->children[span->child_count++];
+      if (!document_scan(text, length, position, start, child))
+        return false;
+    }
+  } else if (open == '"') {
+    text_skip_string(text, length, position);
+  } else {
+    text_skip_value(text, length, position);
+  }
+  
+  span->length = *position-start;
+  return true;
+}
+
+/*
+*** Parsing.
+*/
+
+/*
+Parse the value that exactly fills a range of the text. The root is an object.
+*/
+static json_value document_parse(json_document *document, size_t start, size_t length, bool root)
+{
+  json_source *source = json_source_create_memory((const unsigned char*)document->text+start, length);
+  if (source == NULL)
+    return VALUE_ERROR(JSON_ERROR_MEMORY);
+  json_parser_state *ps = json_parser_create(source, document->flags);
+  if (ps == NULL) {
+    json_source_destroy(source);
+    return VALUE_ERROR(JSON_ERROR_MEMORY);
+  }
+  
+  json_value value = root ? json_parse_object(ps) : json_parse_value(ps);
+  if (ps->error == JSON_ERROR_none_) {
+    json_parse_whitespace(ps);
+    if (ps->wc != WEOF) {
+      json_value_free(value);
+      ps->error = JSON_ERROR_TRAILING;
+    }
+  }
+  if (ps->error != JSON_ERROR_none_)
+    value = VALUE_ERROR(json_parser_error(ps));
+  
+  json_parser_destroy(ps);
+  json_source_destroy(source);
+  return value;
+}
+
+static void document_release(json_document *document, json_error_type error)
+{
+  if (document->root.type != JSON_TYPE_ERROR)
+    json_value_free(document->root);
+  document->root = VALUE_ERROR(error);
+  document_span_free(&document->span);
+}
+
+static json_error_type document_parse_all(json_document *document)
+{
+  document_release(document, JSON_ERROR_MEMORY);
+  json_value root = document_parse(document, 0, document->text_length, true);
+  if (root.type == JSON_TYPE_ERROR) {
+    document->root = root;
+    return (json_error_type)root.as.integer;
+  }
+  size_t position = 0;
+  if (!document_scan(document->text, document->text_length, &position, 0, &document->span)) {
+    json_value_free(root);
+    document_release(document, JSON_ERROR_MEMORY);
+    return JSON_ERROR_MEMORY;
+  }
+  document->root = root;
+  return JSON_ERROR_none_;
+}
+
+/*
+Reparse the smallest container at or below span whose brackets enclose the
+replaced range [offset, end) of the old text, and splice the result in. base
+is where span started in the old text. If that container does not parse on its
+own, its parent is tried next; a failed attempt leaves span and value as they
+were.
+*/
+static json_error_type document_reparse(json_document *document, json_span *span, json_value *value, size_t base, size_t offset, size_t end, size_t inserted_length)
+{
+  /* Find the last child that starts before the edit. */
+  size_t low = 0;
+  size_t high = span->child_count;
+  while (low < high) {
+    size_t middle = low+(high-low)/2;
+    if (base+span->children[middle].offset < offset)
+      low = middle+1;
+    else
+      high = middle;
+  }
+  
+  /* Descend if that child is a container enclosing the edit. */
+  json_value *item = NULL;
+  if (low > 0 && value->type == JSON_TYPE_OBJECT)
+    item = &value->as.object.pairs[low-1].value;
+  else if (low > 0 && value->type == JSON_TYPE_ARRAY)
+    item = &value->as.array[low]; /* Items start at 1. */
+  if (item != NULL && (JSON_TYPE_IS_ARRAY(item->type) || item->type == JSON_TYPE_OBJECT)) {
+    json_span *child = &span->children[low-1];
+    size_t child_base = base+child->offset;
+    if (end < child_base+child->length) {
+      if (document_reparse(document, child, item, child_base, offset, end, inserted_length) == JSON_ERROR_none_) {
+        /* Move what follows the edit. */
+        for (size_t i=low; i<span->child_count; i++)
+          span->children[i].offset = span->children[i].offset-(end-offset)+inserted_length;
+        span->length = span->length-(end-offset)+inserted_length;
+        return JSON_ERROR_none_;
+      }
+    }
+  }
+  
+  /* This container encloses the edit most closely, or the edit broke its child
+  apart (as in "[[1], [2]]" from "[[1, 2]]"): parse its new text. */
+  size_t length = span->length-(end-offset)+inserted_length;
+  json_value replacement = document_parse(document, base, length, false);
+  if (replacement.type == JSON_TYPE_ERROR)
+    return (json_error_type)replacement.as.integer;
+  json_span replacement_span;
+  size_t position = base;
+  if (!document_scan(document->text, base+length, &position, base-span->offset, &replacement_span)) {
+    document_span_free(&replacement_span);
+    json_value_free(replacement);
+    return JSON_ERROR_MEMORY;
+  }
+  
+  /* Splice. */
+  document_span_free(span);
+  *span = replacement_span;
+  json_value_free(*value);
+  *value = replacement;
+  return JSON_ERROR_none_;
+}
+
+/*
+*** Interface.
+*/
+
+json_document *json_document_create(const char *text, size_t length, json_parse_flags flags)
+{
+  /* Internal errors. */
+  assert(text != NULL || length == 0);
+  
+  json_document *document = malloc(sizeof(*document));
+  if (document == NULL)
+    return NULL;
+  *document = (json_document){
+    .text = NULL,
+    .text_length = length,
+    .text_size = length+1 > SIZE_TEXT ? length+1 : SIZE_TEXT,
+    .flags = flags,
+    .root = VALUE_ERROR(JSON_ERROR_MEMORY),
+    .span = {
+      .offset = 0,
+      .length = 0,
+      .child_count = 0,
+      .children = NULL
+    }
+  };
+  document->text = malloc(document->text_size);
+  if (document->text == NULL) {
+    free(document);
+    return NULL;
+  }
+  if (length > 0)
+    memcpy(document->text, text, length);
+  document->text[length] = '\0';
+  
+  /* Parse errors are reported through the root. */
+  document_parse_all(document);
+  return document;
+}
+
+void json_document_destroy(json_document *document)
+{
+  assert(document != NULL);
+  document_release(document, JSON_ERROR_MEMORY);
+  free(document->text);
+  free(document);
+}
+
+json_value json_document_root(json_document *document)
+{
+  assert(document != NULL);
+  return document->root;
+}
+
+const char *json_document_text(json_document *document, size_t *length)
+{
+  assert(document != NULL);
+  if (length != NULL)
+    *length = document->text_length;
+  return document->text;
+}
+
+json_error_type json_document_edit(json_document *document, size_t offset, size_t removed, const char *inserted, size_t inserted_length)
+{
+  /* Internal errors. */
+  assert(document != NULL);
+  assert(inserted != NULL || inserted_length == 0);
+  
+  if (offset > document->text_length || removed > document->text_length-offset)
+    return JSON_ERROR_RANGE;
+  
+  /* Ensure text is big enough. */
+  size_t length = document->text_length-removed+inserted_length;
+  if (length+1 > document->text_size) {
+    size_t text_size = document->text_size;
+    while (length+1 > text_size)
+      text_size *= 2;
+    char *text_new = realloc(document->text, text_size);
+    if (text_new == NULL)
+      return JSON_ERROR_MEMORY;
+    document->text = text_new;
+    document->text_size = text_size;
+  }
+  
+  /* Edit text. */
+  size_t end = offset+removed;
+  memmove(document->text+offset+inserted_length, document->text+end, document->text_length-end+1 /* NUL. */);
+  if (inserted_length > 0)
+    memcpy(document->text+offset, inserted, inserted_length);
+  document->text_length = length;
+  
+  /* Reparse everything if the edit is not inside the root object. */
+  json_span *span = &document->span;
+  if (document->root.type == JSON_TYPE_ERROR || offset <= span->offset || end >= span->offset+span->length)
+    return document_parse_all(document);
+  
+  /* A local failure may still be valid text as a whole. */
+  if (document_reparse(document, span, &document->root, span->offset, offset, end, inserted_length) != JSON_ERROR_none_)
+    return document_parse_all(document);
+  return JSON_ERROR_none_;
+}
@@ -0,0 +1,54 @@
+/*
+document.h - jsonparse
+Modified 2026-10-19
+*/
+
+#ifndef JSON_DOCUMENT_H
+#define JSON_DOCUMENT_H
+
+/* Header-specific includes. */
+#include "common.h"
+#include "structure.h"
+#include "errors.h"
+#include "parser.h"
+
+/*
+*** Interface.
+
+A document keeps its UTF-8 text next to the parsed tree, together with the
+byte span of every value. json_document_edit replaces a range of the text and
+reparses only the smallest array or object whose brackets enclose the edit,
+then splices the result into the tree. If that container does not parse on its
+own, its enclosing containers are tried outwards and finally the whole
+document. Edits that touch the brackets of the root object, and edits to a
+document that failed to parse, reparse everything. If the whole document does
+not parse, the edit is kept and the root turns into the error; the next edit
+reparses the whole document. Offsets are in bytes. The root belongs to the
+document and is only valid until the next edit.
+*/
+
+#include "document_public.h"
+
+/*
+Source map. Spans are relative to the start of their parent, so an edit only
+moves the spans that follow it in each enclosing container. Children line up
+with array items and object pairs.
+*/
+
+typedef struct json_span_ {
+  size_t offset;
+  size_t length;
+  size_t child_count;
+  struct json_span_ *children;
+} json_span;
+
+struct json_document_ {
+  char *text;
+  size_t text_length;
+  size_t text_size;
+  json_parse_flags flags;
+  json_value root;
+  json_span span; /* Offset from the start of the text. */
+};
+
+#endif /* !JSON_DOCUMENT_H */
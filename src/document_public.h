@@ -0,0 +1,13 @@
+#ifndef JSON_DOCUMENT_PUBLIC_H
+#define JSON_DOCUMENT_PUBLIC_H
+
+typedef struct json_document_ json_document;
+
+json_document *json_document_create(const char *text, size_t length, json_parse_flags flags);
+void json_document_destroy(json_document *document);
+
+json_value json_document_root(json_document *document);
+const char *json_document_text(json_document *document, size_t *length);
+json_error_type json_document_edit(json_document *document, size_t offset, size_t removed, const char *inserted, size_t inserted_length);
+
+#endif /* !JSON_DOCUMENT_PUBLIC_H */
@@ -1,6 +1,6 @@
 /*
 errors.c - jsonparse
-Modified 2022-09-17
+Modified 2026-10-19
 */
 
 /* Header-specific includes. */
@@ -19,6 +19,7 @@ wchar_t *json_error_type_desc[] = {
   L"Expected '\"' as start of string or key.",
   L"Expected '\"' at end of string or key.",
   L"Illegal escape sequence in string.",
+  L"Unescaped control character in string.",
   L"Illegal value.",
   L"Expected '[' at start of array.",
   L"Expected ']' at end of array.",
@@ -27,4 +28,16 @@ wchar_t *json_error_type_desc[] = {
   L"Expected 'null'.",
   L"Malformed floating-point number.",
   L"Malformed integer number.",
+  L"Failed to write output.",
+  L"Writer call does not fit the current nesting.",
+  L"Infinities and NaN cannot be written as JSON.",
+  L"Malformed UTF-8 in input.",
+  L"Malformed compressed input.",
+  L"Value does not match the schema.",
+  L"Unexpected characters after value.",
+  L"Range lies outside the text.",
+  L"Malformed or duplicate JSON Pointer path.",
+  L"No value at the JSON Pointer path.",
+  L"Index is malformed or does not match the input.",
+  L"Malformed patch operation, or a failed test.",
 };
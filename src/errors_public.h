@@ -0,0 +1,38 @@
+#ifndef JSON_ERRORS_PUBLIC_H
+#define JSON_ERRORS_PUBLIC_H
+
+typedef enum json_error_type {
+  JSON_ERROR_none_,
+  JSON_ERROR_FILE,
+  JSON_ERROR_MEMORY,
+  JSON_ERROR_OBJECTOPEN,
+  JSON_ERROR_OBJECTCLOSE,
+  JSON_ERROR_PAIRSEPERATOR,
+  JSON_ERROR_STRINGOPEN,
+  JSON_ERROR_STRINGCLOSE,
+  JSON_ERROR_STRINGESCAPE,
+  JSON_ERROR_STRINGCONTROL,
+  JSON_ERROR_VALUE,
+  JSON_ERROR_ARRAYOPEN,
+  JSON_ERROR_ARRAYCLOSE,
+  JSON_ERROR_TRUE,
+  JSON_ERROR_FALSE,
+  JSON_ERROR_NULL,
+  JSON_ERROR_FLOATING,
+  JSON_ERROR_INTEGER,
+  JSON_ERROR_WRITE,
+  JSON_ERROR_WRITERSTATE,
+  JSON_ERROR_NONFINITE,
+  JSON_ERROR_ENCODING,
+  JSON_ERROR_DECOMPRESS,
+  JSON_ERROR_SCHEMA,
+  JSON_ERROR_TRAILING,
+  JSON_ERROR_RANGE,
+  JSON_ERROR_PATH,
+  JSON_ERROR_MISSING,
+  JSON_ERROR_INDEX,
+  JSON_ERROR_PATCH,
+  JSON_ERROR_max_
+} json_error_type;
+
+#endif /* !JSON_ERRORS_PUBLIC_H */
@@ -0,0 +1,565 @@
+/*
+hash.c - jsonparse
+Modified 2026-10-19
+*/
+
+/* Header-specific includes. */
+#include "hash.h"
+
+/* Implementation-specific includes. */
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+
+/* Constants. */
+#define SIZE_LINEAR 8 /* Objects up to this size are matched by scanning. */
+#define SEED_NULL 0x6a09e667f3bcc908
+#define SEED_BOOLEAN 0xbb67ae8584caa73b
+#define SEED_NUMBER 0x3c6ef372fe94f82b
+#define SEED_STRING 0xa54ff53a5f1d36f1
+#define SEED_ARRAY 0x510e527fade682d1
+#define SEED_OBJECT 0x9b05688c2b3e6c1f
+#define SEED_DECIMAL 0x1f83d9abfb41bd6b
+#define SIZE_FLOATING 32
+
+/*
+*** Helpers.
+*/
+
+static uint64_t hash_mix(uint64_t hash)
+{
+  /* SplitMix64 finalizer. */
+  hash ^= hash >> 30;
+  hash *= 0xbf58476d1ce4e5b9;
+  hash ^= hash >> 27;
+  hash *= 0x94d049bb133111eb;
+  hash ^= hash >> 31;
+  return hash;
+}
+
+/*
+Convert a floating-point number to an integer if it represents one exactly.
+*/
+static bool floating_as_integer(json_floating floating, json_integer *integer)
+{
+  if (!(floating >= -9223372036854775808.0 && floating < 9223372036854775808.0))
+    return false;
+  *integer = (json_integer)floating;
+  return (json_floating)*integer == floating;
+}
+
+static uint64_t hash_floating(json_floating floating)
+{
+  json_integer integer;
+  if (floating_as_integer(floating, &integer))
+    return hash_mix(SEED_NUMBER^(uint64_t)integer);
+  uint64_t bits;
+  memcpy(&bits, &floating, sizeof(bits));
+  return hash_mix(SEED_NUMBER^hash_mix(bits));
+}
+
+/*
+A number in exact decimal form. The significant digits d1...dn, without leading
+or trailing zeros, stand for 0.d1...dn * 10^exponent; they are read from the
+text, skipping a decimal point. Zero has no digits.
+*/
+typedef struct number_decimal_ {
+  bool negative;
+  const wchar_t *digits;
+  size_t count;
+  json_integer exponent;
+} number_decimal;
+
+/*
+Read the decimal form of a number's text. Fails if the exponent is out of
+range.
+*/
+static bool decimal_parse(const wchar_t *text, number_decimal *decimal)
+{
+  *decimal = (number_decimal){
+    .negative = false,
+    .digits = NULL,
+    .count = 0,
+    .exponent = 0
+  };
+  bool negative = *text == L'-';
+  if (*text == L'-' || *text == L'+')
+    text++;
+  
+  /* Mantissa. */
+  json_integer index = 0; /* Of the current digit. */
+  json_integer point = -1; /* Digits before the decimal point. */
+  json_integer first = -1; /* Index of the first significant digit. */
+  json_integer last = -1; /* Index of the last one. */
+  for (; (*text >= L'0' && *text <= L'9') || *text == L'.'; text++) {
+    if (*text == L'.') {
+      point = index;
+      continue;
+    }
+    if (*text != L'0') {
+      if (first == -1) {
+        first = index;
+        decimal->digits = text;
+      }
+      last = index;
+    }
+    index++;
+  }
+  if (point == -1)
+    point = index;
+  
+  /* Exponent. */
+  json_integer exponent = 0;
+  if (*text == L'e' || *text == L'E') {
+    text++;
+    bool exponent_negative = *text == L'-';
+    if (*text == L'-' || *text == L'+')
+      text++;
+    for (; *text >= L'0' && *text <= L'9'; text++) {
+      if (exponent > (INT64_MAX/4-(*text-L'0'))/10)
+        return false;
+      exponent = exponent*10+(*text-L'0');
+    }
+    if (exponent_negative)
+      exponent = -exponent;
+  }
+  
+  if (first != -1) {
+    decimal->negative = negative;
+    decimal->count = (size_t)(last-first+1);
+    decimal->exponent = point-first+exponent;
+  }
+  return true;
+}
+
+static bool decimal_equal(number_decimal a, number_decimal b)
+{
+  if (a.negative != b.negative || a.count != b.count || a.exponent != b.exponent)
+    return false;
+  const wchar_t *digit_a = a.digits;
+  const wchar_t *digit_b = b.digits;
+  for (size_t i=0; i<a.count; i++) {
+    if (*digit_a == L'.')
+      digit_a++;
+    if (*digit_b == L'.')
+      digit_b++;
+    if (*digit_a++ != *digit_b++)
+      return false;
+  }
+  return true;
+}
+
+static uint64_t decimal_hash(number_decimal decimal)
+{
+  uint64_t hash = SEED_DECIMAL^(uint64_t)decimal.negative;
+  hash = hash_mix(hash+(uint64_t)decimal.exponent);
+  const wchar_t *digit = decimal.digits;
+  for (size_t i=0; i<decimal.count; i++) {
+    if (*digit == L'.')
+      digit++;
+    hash = (hash^(uint64_t)*digit++)*0x100000001b3;
+  }
+  return hash_mix(hash);
+}
+
+/*
+Convert a decimal to an integer if it has an integer value that fits.
+*/
+static bool decimal_as_integer(number_decimal decimal, json_integer *integer)
+{
+  if (decimal.count == 0) {
+    *integer = 0;
+    return true;
+  }
+  if (decimal.exponent < (json_integer)decimal.count || decimal.exponent > 19)
+    return false;
+  uint64_t magnitude = 0;
+  const wchar_t *digit = decimal.digits;
+  for (json_integer i=0; i<decimal.exponent; i++) {
+    uint64_t value = 0;
+    if ((size_t)i < decimal.count) {
+      if (*digit == L'.')
+        digit++;
+      value = (uint64_t)(*digit++-L'0');
+    }
+    if (magnitude > (UINT64_MAX-value)/10)
+      return false;
+    magnitude = magnitude*10+value;
+  }
+  if (magnitude > (decimal.negative ? (uint64_t)INT64_MAX+1 : (uint64_t)INT64_MAX))
+    return false;
+  *integer = decimal.negative ? -(json_integer)(magnitude-1)-1 : (json_integer)magnitude;
+  return true;
+}
+
+/*
+Take the decimal form of the shortest text that reads back as floating. text
+must have room for SIZE_FLOATING characters and holds the digits.
+*/
+static bool floating_decimal(json_floating floating, wchar_t *text, number_decimal *decimal)
+{
+  char bytes[SIZE_FLOATING];
+  for (int precision=15; precision<=17; precision++) {
+    snprintf(bytes, sizeof(bytes), "%.*g", precision, floating);
+    if (strtod(bytes, NULL) == floating)
+      break;
+  }
+  size_t i = 0;
+  do
+    text[i] = (wchar_t)(unsigned char)bytes[i];
+  while (bytes[i++] != '\0');
+  return decimal_parse(text, decimal);
+}
+
+/*
+A number in canonical form: an integer if it has an exact integer value that
+fits json_integer; otherwise a floating-point number, or the exact decimal form
+of an unconverted number, which keeps numbers beyond the range or precision of
+json_floating apart. Unconverted numbers whose text cannot be read have no form
+(JSON_TYPE_none_) and equal no other number.
+*/
+typedef struct number_form_ {
+  json_type type; /* JSON_TYPE_INTEGER, JSON_TYPE_FLOATING or JSON_TYPE_NUMBER. */
+  json_integer integer;
+  json_floating floating;
+  number_decimal decimal;
+} number_form;
+
+static number_form number_canonical(json_value value)
+{
+  number_form form = {
+    .type = JSON_TYPE_none_,
+    .integer = 0,
+    .floating = 0
+  };
+  if (value.type == JSON_TYPE_INTEGER || (value.type == JSON_TYPE_FLOATING && floating_as_integer(value.as.floating, &form.integer))) {
+    form.type = JSON_TYPE_INTEGER;
+    if (value.type == JSON_TYPE_INTEGER)
+      form.integer = value.as.integer;
+  } else if (value.type == JSON_TYPE_FLOATING) {
+    form.type = JSON_TYPE_FLOATING;
+    form.floating = value.as.floating;
+  } else if (json_value_integer(value, &form.integer)) {
+    form.type = JSON_TYPE_INTEGER;
+  } else if (decimal_parse(value.as.number->text, &form.decimal)) {
+    form.type = decimal_as_integer(form.decimal, &form.integer) ? JSON_TYPE_INTEGER : JSON_TYPE_NUMBER;
+  }
+  return form;
+}
+
+static uint64_t number_hash(json_value value)
+{
+  number_form form = number_canonical(value);
+  if (form.type == JSON_TYPE_INTEGER)
+    return hash_mix(SEED_NUMBER^(uint64_t)form.integer);
+  if (form.type == JSON_TYPE_FLOATING)
+    return hash_floating(form.floating);
+  if (form.type == JSON_TYPE_none_)
+    return hash_mix(SEED_NUMBER^json_key_hash(value.as.number->text));
+  
+  /* Decimals that a floating-point number represents exactly hash like it. */
+  json_floating floating;
+  wchar_t text[SIZE_FLOATING];
+  number_decimal decimal;
+  if (json_value_floating(value, &floating) && floating_decimal(floating, text, &decimal) && decimal_equal(decimal, form.decimal))
+    return hash_floating(floating);
+  return decimal_hash(form.decimal);
+}
+
+static bool numbers_equal(json_value a, json_value b)
+{
+  number_form form_a = number_canonical(a);
+  number_form form_b = number_canonical(b);
+  if (form_a.type == JSON_TYPE_FLOATING && form_b.type == JSON_TYPE_NUMBER) {
+    number_form form = form_a;
+    form_a = form_b;
+    form_b = form;
+  }
+  
+  /* A decimal equals a floating-point number whose shortest text it is. */
+  wchar_t text[SIZE_FLOATING];
+  if (form_a.type == JSON_TYPE_NUMBER && form_b.type == JSON_TYPE_FLOATING)
+    return floating_decimal(form_b.floating, text, &form_b.decimal) && decimal_equal(form_a.decimal, form_b.decimal);
+  
+  if (form_a.type != form_b.type)
+    return false;
+  if (form_a.type == JSON_TYPE_INTEGER)
+    return form_a.integer == form_b.integer;
+  if (form_a.type == JSON_TYPE_FLOATING)
+    return form_a.floating == form_b.floating;
+  if (form_a.type == JSON_TYPE_NUMBER)
+    return decimal_equal(form_a.decimal, form_b.decimal);
+  return false;
+}
+
+static bool objects_equal(json_object a, json_object b)
+{
+  if (a.pair_count != b.pair_count)
+    return false;
+  
+  /* Fast path: same key order. */
+  size_t i = 0;
+  while (i < a.pair_count && wcscmp(a.pairs[i].key, b.pairs[i].key) == 0) {
+    if (!json_value_equal(a.pairs[i].value, b.pairs[i].value))
+      return false;
+    i++;
+  }
+  if (i == a.pair_count)
+    return true;
+  
+  /* Small objects: match the remaining keys by scanning. */
+  if (a.pair_count <= SIZE_LINEAR) {
+    for (; i<a.pair_count; i++) {
+      size_t j = 0;
+      while (j < b.pair_count && wcscmp(a.pairs[i].key, b.pairs[j].key) != 0)
+        j++;
+      if (j == b.pair_count || !json_value_equal(a.pairs[i].value, b.pairs[j].value))
+        return false;
+    }
+    return true;
+  }
+  
+  /* Large objects: match the remaining keys through an index. */
+  json_key_index index;
+  if (!json_key_index_create(&index, b)) {
+    /* Out of memory; fall back to scanning. */
+    for (; i<a.pair_count; i++) {
+      size_t j = 0;
+      while (j < b.pair_count && wcscmp(a.pairs[i].key, b.pairs[j].key) != 0)
+        j++;
+      if (j == b.pair_count || !json_value_equal(a.pairs[i].value, b.pairs[j].value))
+        return false;
+    }
+    return true;
+  }
+  bool equal = true;
+  for (; i<a.pair_count && equal; i++) {
+    size_t j = json_key_index_find(&index, a.pairs[i].key);
+    equal = j != JSON_KEY_INDEX_NONE && json_value_equal(a.pairs[i].value, b.pairs[j].value);
+  }
+  json_key_index_destroy(&index);
+  return equal;
+}
+
+/*
+*** Interface.
+*/
+
+uint64_t json_value_hash(json_value value)
+{
+  assert(JSON_TYPE_HAS_MEANING(value.type));
+  #ifdef __GNUC__
+  #ifdef __clang__
+  #pragma clang diagnostic push
+  #pragma clang diagnostic ignored "-Wswitch-enum"
+  #else
+  #pragma GCC diagnostic push
+  #pragma GCC diagnostic ignored "-Wswitch-enum"
+  #endif
+  #endif
+  uint64_t hash = 0;
+  switch (value.type) {
+    case JSON_TYPE_NULL:
+      hash = hash_mix(SEED_NULL);
+      break;
+    case JSON_TYPE_BOOLEAN:
+      hash = hash_mix(SEED_BOOLEAN^(value.as.integer != 0));
+      break;
+    case JSON_TYPE_INTEGER:
+    case JSON_TYPE_FLOATING:
+    case JSON_TYPE_NUMBER:
+      hash = number_hash(value);
+      break;
+    case JSON_TYPE_STRING:
+      hash = hash_mix(SEED_STRING^json_key_hash(value.as.string));
+      break;
+    case JSON_TYPE_ARRAY:
+      assert(JSON_ARRAY_IS_INTEGROUS(value));
+      hash = SEED_ARRAY;
+      for (json_integer i=1; i<=value.as.array[0].as.integer; i++)
+        hash = hash_mix(hash+json_value_hash(value.as.array[i]));
+      break;
+    case JSON_TYPE_INTEGER_ARRAY:
+    case JSON_TYPE_FLOATING_ARRAY:
+      /* Same as the equivalent regular array. */
+      hash = SEED_ARRAY;
+      for (size_t i=0; i<value.as.packed.count; i++)
+        hash = hash_mix(hash+json_value_hash(json_value_array_item(value, i)));
+      break;
+    case JSON_TYPE_OBJECT:
+      /* Pairs are combined commutatively, so key order does not matter. */
+      assert(JSON_OBJECT_IS_INTEGROUS(value));
+      hash = SEED_OBJECT+value.as.object.pair_count;
+      for (size_t i=0; i<value.as.object.pair_count; i++) {
+        uint64_t hash_key = json_key_hash(value.as.object.pairs[i].key);
+        hash += hash_mix(hash_key^hash_mix(json_value_hash(value.as.object.pairs[i].value)+hash_key));
+      }
+      hash = hash_mix(hash);
+      break;
+    case JSON_TYPE_SHARED:
+      /* Memoize. 0 marks a hash that has not been computed yet. */
+      hash = atomic_load_explicit(&value.as.shared->hash, memory_order_relaxed);
+      if (hash == 0) {
+        hash = json_value_hash(value.as.shared->value);
+        atomic_store_explicit(&value.as.shared->hash, hash, memory_order_relaxed);
+      }
+      return hash;
+    default:
+      assert(false);
+  }
+  #ifdef __GNUC__
+  #ifdef __clang__
+  #pragma clang diagnostic pop
+  #else
+  #pragma GCC diagnostic pop
+  #endif
+  #endif
+  return hash != 0 ? hash : 1;
+}
+
+bool json_value_equal(json_value a, json_value b)
+{
+  assert(JSON_TYPE_HAS_MEANING(a.type));
+  assert(JSON_TYPE_HAS_MEANING(b.type));
+  
+  /* Frozen subtrees: identity and memoized hashes decide cheaply. */
+  if (a.type == JSON_TYPE_SHARED && b.type == JSON_TYPE_SHARED) {
+    if (a.as.shared == b.as.shared)
+      return true;
+    if (json_value_hash(a) != json_value_hash(b))
+      return false;
+  }
+  a = json_value_deref(a);
+  b = json_value_deref(b);
+  
+  /* Numbers compare by value. */
+  if (a.type == JSON_TYPE_NUMBER && b.type == JSON_TYPE_NUMBER && wcscmp(a.as.number->text, b.as.number->text) == 0)
+    return true;
+  bool a_number = a.type == JSON_TYPE_INTEGER || a.type == JSON_TYPE_FLOATING || a.type == JSON_TYPE_NUMBER;
+  bool b_number = b.type == JSON_TYPE_INTEGER || b.type == JSON_TYPE_FLOATING || b.type == JSON_TYPE_NUMBER;
+  if (a_number || b_number)
+    return a_number && b_number && numbers_equal(a, b);
+  
+  /* Packed arrays compare item by item with any other array. */
+  if (JSON_TYPE_IS_ARRAY(a.type) && JSON_TYPE_IS_ARRAY(b.type) && (JSON_TYPE_IS_PACKED(a.type) || JSON_TYPE_IS_PACKED(b.type))) {
+    size_t count = json_value_array_length(a);
+    if (count != json_value_array_length(b))
+      return false;
+    if (a.type == b.type && a.type == JSON_TYPE_INTEGER_ARRAY)
+      return memcmp(a.as.packed.items, b.as.packed.items, count*sizeof(json_integer)) == 0;
+    for (size_t i=0; i<count; i++)
+      if (!json_value_equal(json_value_array_item(a, i), json_value_array_item(b, i)))
+        return false;
+    return true;
+  }
+  
+  if (a.type != b.type)
+    return false;
+  #ifdef __GNUC__
+  #ifdef __clang__
+  #pragma clang diagnostic push
+  #pragma clang diagnostic ignored "-Wswitch-enum"
+  #else
+  #pragma GCC diagnostic push
+  #pragma GCC diagnostic ignored "-Wswitch-enum"
+  #endif
+  #endif
+  switch (a.type) {
+    case JSON_TYPE_NULL:
+      return true;
+    case JSON_TYPE_BOOLEAN:
+      return (a.as.integer != 0) == (b.as.integer != 0);
+    case JSON_TYPE_STRING:
+      return wcscmp(a.as.string, b.as.string) == 0;
+    case JSON_TYPE_ARRAY:
+      assert(JSON_ARRAY_IS_INTEGROUS(a));
+      assert(JSON_ARRAY_IS_INTEGROUS(b));
+      if (a.as.array[0].as.integer != b.as.array[0].as.integer)
+        return false;
+      for (json_integer i=1; i<=a.as.array[0].as.integer; i++)
+        if (!json_value_equal(a.as.array[i], b.as.array[i]))
+          return false;
+      return true;
+    case JSON_TYPE_OBJECT:
+      assert(JSON_OBJECT_IS_INTEGROUS(a));
+      assert(JSON_OBJECT_IS_INTEGROUS(b));
+      return objects_equal(a.as.object, b.as.object);
+    default:
+      assert(false);
+      return false;
+  }
+  #ifdef __GNUC__
+  #ifdef __clang__
+  #pragma clang diagnostic pop
+  #else
+  #pragma GCC diagnostic pop
+  #endif
+  #endif
+}
+
+uint64_t json_key_hash(wchar_t *key)
+{
+  /* FNV-1a over code units. */
+  uint64_t hash = 0xcbf29ce484222325;
+  for (; *key != L'\0'; key++) {
+    hash ^= (uint64_t)(uint32_t)*key;
+    hash *= 0x100000001b3;
+  }
+  return hash;
+}
+
+bool json_key_index_create(json_key_index *index, json_object object)
+{
+  /* Internal errors. */
+  assert(index != NULL);
+  
+  /* Keep the load factor at or below one half. */
+  size_t size = 1;
+  while (size < 2*object.pair_count)
+    size *= 2;
+  *index = (json_key_index){
+    .object = object,
+    .slots = malloc(size*sizeof(*index->slots)),
+    .mask = size-1
+  };
+  if (index->slots == NULL)
+    return false;
+  for (size_t i=0; i<size; i++)
+    index->slots[i] = JSON_KEY_INDEX_NONE;
+  
+  /* Insert pairs. The first of duplicate keys wins. */
+  for (size_t i=0; i<object.pair_count; i++) {
+    size_t slot = json_key_hash(object.pairs[i].key) & index->mask;
+    while (index->slots[slot] != JSON_KEY_INDEX_NONE && wcscmp(object.pairs[index->slots[slot]].key, object.pairs[i].key) != 0)
+      slot = (slot+1) & index->mask;
+    if (index->slots[slot] == JSON_KEY_INDEX_NONE)
+      index->slots[slot] = i;
+  }
+  return true;
+}
+
+size_t json_key_index_find(json_key_index *index, wchar_t *key)
+{
+  /* Internal errors. */
+  assert(index != NULL);
+  assert(key != NULL);
+  
+  size_t slot = json_key_hash(key) & index->mask;
+  while (index->slots[slot] != JSON_KEY_INDEX_NONE) {
+    if (wcscmp(index->object.pairs[index->slots[slot]].key, key) == 0)
+      return index->slots[slot];
+    slot = (slot+1) & index->mask;
+  }
+  return JSON_KEY_INDEX_NONE;
+}
+
+void json_key_index_destroy(json_key_index *index)
+{
+  /* Internal errors. */
+  assert(index != NULL);
+  
+  free(index->slots);
+  index->slots = NULL;
+}
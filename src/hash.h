@@ -0,0 +1,44 @@
+/*
+hash.h - jsonparse
+Modified 2026-10-19
+*/
+
+#ifndef JSON_HASH_H
+#define JSON_HASH_H
+
+/* Header-specific includes. */
+#include "common.h"
+#include "structure.h"
+
+/*
+*** Interface.
+
+Hashes and equality are structural: object keys compare regardless of order,
+and integers equal floating-point numbers of the same value. Unconverted
+numbers (JSON_PARSE_LAZY_NUMBERS) compare exactly by their decimal value, so
+large IDs that json_floating would round stay distinct; such a number equals a
+floating-point number only if it is that number's shortest text. Hashes of frozen
+subtrees are memoized, and identical or differently-hashed frozen subtrees are
+told apart without walking them.
+*/
+
+#include "hash_public.h"
+
+/*
+Key index. Maps the keys of an object to their pair indices.
+*/
+
+typedef struct json_key_index_ {
+  json_object object;
+  size_t *slots;
+  size_t mask;
+} json_key_index;
+
+#define JSON_KEY_INDEX_NONE SIZE_MAX
+
+uint64_t json_key_hash(wchar_t *key);
+bool json_key_index_create(json_key_index *index, json_object object);
+size_t json_key_index_find(json_key_index *index, wchar_t *key);
+void json_key_index_destroy(json_key_index *index);
+
+#endif /* !JSON_HASH_H */
@@ -0,0 +1,7 @@
+#ifndef JSON_HASH_PUBLIC_H
+#define JSON_HASH_PUBLIC_H
+
+uint64_t json_value_hash(json_value value);
+bool json_value_equal(json_value a, json_value b);
+
+#endif /* !JSON_HASH_PUBLIC_H */
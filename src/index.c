@@ -0,0 +1,597 @@
+/*
+index.c - jsonparse
+Modified 2026-10-19
+*/
+
+/* Header-specific includes. */
+#include "index.h"
+
+/* Implementation-specific includes. */
+#include "source.h"
+#include "tools.h"
+#include <assert.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <wchar.h>
+
+/* Constants. */
+#define SIZE_BUFFER 1048576
+#define SIZE_STACK 64
+#define SIZE_DEPTH 64
+#define SIZE_MAGIC 8
+
+/* Helpers. */
+#define BYTE_IS_WHITESPACE(byte) \
+  (byte == ' ' || byte == '\n' || byte == '\r' || byte == '\t')
+#define BYTE_IS_DELIMITER(byte) \
+  (BYTE_IS_WHITESPACE(byte) || byte == ',' || byte == ':' || byte == ']' || byte == '}')
+#define VALUE_ERROR(error) \
+  ((json_value){ .type = JSON_TYPE_ERROR, .as.integer = error })
+
+/*
+*** Building.
+*/
+
+typedef struct index_frame_ {
+  uint64_t offset;
+  uint64_t key;
+  uint64_t first_child;
+  uint64_t child_count;
+  uint64_t member_key; /* Key of the member being read. */
+  char close;
+  bool expect_key;
+} index_frame;
+
+typedef struct index_builder_ {
+  FILE *input;
+  unsigned char *buffer;
+  size_t cursor;
+  size_t end;
+  uint64_t position;
+  size_t level_count;
+  FILE **levels; /* Records of each level until they are copied out. */
+  uint64_t *counts;
+  index_frame *stack;
+  size_t stack_count;
+  size_t stack_size;
+  json_error_type error;
+} index_builder;
+
+static bool index_fail(index_builder *ib, json_error_type error)
+{
+  if (ib->error == JSON_ERROR_none_)
+    ib->error = error;
+  return false;
+}
+
+static int index_peek(index_builder *ib)
+{
+  if (ib->cursor == ib->end) {
+    ib->cursor = 0;
+    ib->end = fread(ib->buffer, 1, SIZE_BUFFER, ib->input);
+    if (ib->end == 0)
+      return EOF;
+  }
+  return ib->buffer[ib->cursor];
+}
+
+static void index_advance(index_builder *ib)
+{
+  ib->cursor++;
+  ib->position++;
+}
+
+static bool index_skip_input_string(index_builder *ib)
+{
+  /* '"' */
+  index_advance(ib);
+  int byte;
+  while ((byte = index_peek(ib)) != EOF) {
+    index_advance(ib);
+    if (byte == '"')
+      return true;
+    if (byte == '\\') {
+      if (index_peek(ib) == EOF)
+        break;
+      index_advance(ib);
+    }
+  }
+  return index_fail(ib, JSON_ERROR_STRINGCLOSE);
+}
+
+/*
+Write the record of a value at depth level, if the index reaches that deep.
+*/
+static bool index_emit(index_builder *ib, size_t level, json_index_record record)
+{
+  if (level >= ib->level_count)
+    return true;
+  if (fwrite(&record, sizeof(record), 1, ib->levels[level]) != 1)
+    return index_fail(ib, JSON_ERROR_WRITE);
+  ib->counts[level]++;
+  if (level > 0)
+    ib->stack[level-1].child_count++;
+  return true;
+}
+
+/*
+Follow the structure of the input and record every value. Separators are not
+checked beyond what is needed to tell keys from values.
+*/
+static bool index_scan(index_builder *ib)
+{
+  bool root = false;
+  while (true) {
+    int byte;
+    while ((byte = index_peek(ib)) != EOF && BYTE_IS_WHITESPACE(byte))
+      index_advance(ib);
+    if (byte == EOF)
+      break;
+    uint64_t start = ib->position;
+    size_t level = ib->stack_count;
+    index_frame *parent = level > 0 ? &ib->stack[level-1] : NULL;
+  
+    /* Separators. */
+    if (byte == ',' || byte == ':') {
+      if (parent == NULL)
+        return index_fail(ib, JSON_ERROR_TRAILING);
+      parent->expect_key = byte == ',' && parent->close == '}';
+      index_advance(ib);
+      continue;
+    }
+
+    /* Close a container. */
+    if (byte == ']' || byte == '}') {
+      if (parent == NULL)
+        return index_fail(ib, byte == '}' ? JSON_ERROR_OBJECTCLOSE : JSON_ERROR_ARRAYCLOSE);
+      if (parent->close != byte)
+        return index_fail(ib, parent->close == '}' ? JSON_ERROR_OBJECTCLOSE : JSON_ERROR_ARRAYCLOSE);
+      index_advance(ib);
+      ib->stack_count--;
+      json_index_record record = {
+        .offset = parent->offset,
+        .length = ib->position-parent->offset,
+        .key = parent->key,
+        .first_child = parent->first_child,
+        .child_count = parent->child_count
+      };
+      if (!index_emit(ib, ib->stack_count, record))
+        return false;
+      continue;
+    }
+
+    /* Keys. */
+    if (byte == '"' && parent != NULL && parent->expect_key) {
+      parent->member_key = start;
+      parent->expect_key = false;
+      if (!index_skip_input_string(ib))
+        return false;
+      continue;
+    }
+
+    /* Values. */
+    if (parent == NULL) {
+      if (root)
+        return index_fail(ib, JSON_ERROR_TRAILING);
+      root = true;
+    }
+    uint64_t key = parent != NULL && parent->close == '}' ? parent->member_key : JSON_INDEX_NONE;
+    if (byte == '{' || byte == '[') {
+      /* Ensure stack is big enough. */
+      if (ib->stack_count >= ib->stack_size) {
+        size_t stack_size = 2*ib->stack_size;
+        index_frame *stack_new = realloc(ib->stack, stack_size*sizeof(*ib->stack));
+        if (stack_new == NULL)
+          return index_fail(ib, JSON_ERROR_MEMORY);
+        ib->stack = stack_new;
+        ib->stack_size = stack_size;
+      }
+      ib->stack[ib->stack_count++] = (index_frame){
+        .offset = start,
+        .key = key,
+        .first_child = level+1 < ib->level_count ? ib->counts[level+1] : 0,
+        .child_count = 0,
+        .member_key = JSON_INDEX_NONE,
+        .close = byte == '{' ? '}' : ']',
+        .expect_key = byte == '{'
+      };
+      index_advance(ib);
+      continue;
+    }
+    if (byte == '"') {
+      if (!index_skip_input_string(ib))
+        return false;
+    } else {
+      while ((byte = index_peek(ib)) != EOF && !BYTE_IS_DELIMITER(byte))
+        index_advance(ib);
+    }
+    json_index_record record = {
+      .offset = start,
+      .length = ib->position-start,
+      .key = key,
+      .first_child = 0,
+      .child_count = 0
+    };
+    if (!index_emit(ib, level, record))
+      return false;
+  }
+
+  if (ferror(ib->input))
+    return index_fail(ib, JSON_ERROR_FILE);
+  if (ib->stack_count > 0)
+    return index_fail(ib, ib->stack[ib->stack_count-1].close == '}' ? JSON_ERROR_OBJECTCLOSE : JSON_ERROR_ARRAYCLOSE);
+  if (!root)
+    return index_fail(ib, JSON_ERROR_VALUE);
+  return true;
+}
+
+static bool index_write(index_builder *ib, FILE *output)
+{
+  uint64_t header[2] = { ib->position, ib->level_count };
+  if (fwrite(JSON_INDEX_MAGIC, 1, SIZE_MAGIC, output) != SIZE_MAGIC || fwrite(header, sizeof(*header), 2, output) != 2 || fwrite(ib->counts, sizeof(*ib->counts), ib->level_count, output) != ib->level_count)
+    return index_fail(ib, JSON_ERROR_WRITE);
+  for (size_t i=0; i<ib->level_count; i++) {
+    rewind(ib->levels[i]);
+    size_t length;
+    while ((length = fread(ib->buffer, 1, SIZE_BUFFER, ib->levels[i])) > 0)
+      if (fwrite(ib->buffer, 1, length, output) != length)
+        return index_fail(ib, JSON_ERROR_WRITE);
+    if (ferror(ib->levels[i]))
+      return index_fail(ib, JSON_ERROR_FILE);
+  }
+  if (fflush(output) != 0)
+    return index_fail(ib, JSON_ERROR_WRITE);
+  return true;
+}
+
+static void index_builder_free(index_builder *ib)
+{
+  if (ib->levels != NULL)
+    for (size_t i=0; i<ib->level_count; i++)
+      if (ib->levels[i] != NULL)
+        fclose(ib->levels[i]);
+  free(ib->levels);
+  free(ib->counts);
+  free(ib->stack);
+  free(ib->buffer);
+}
+
+/*
+*** Lookup.
+*/
+
+static bool index_map(const char *path, void **map, size_t *length)
+{
+  int fd = open(path, O_RDONLY);
+  if (fd < 0)
+    return false;
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+    close(fd);
+    return false;
+  }
+  *length = (size_t)st.st_size;
+  *map = mmap(NULL, *length, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (*map == MAP_FAILED) {
+    *map = NULL;
+    return false;
+  }
+  return true;
+}
+
+/*
+Check the header of a mapped index against its input, and locate the levels.
+*/
+static json_error_type index_check(json_index *index)
+{
+  const char *map = index->index_map;
+  size_t header = SIZE_MAGIC+2*sizeof(uint64_t);
+  if (index->index_length < header || memcmp(map, JSON_INDEX_MAGIC, SIZE_MAGIC) != 0)
+    return JSON_ERROR_INDEX;
+  const uint64_t *fields = (const void*)(map+SIZE_MAGIC);
+  if (fields[0] != index->text_length || fields[1] == 0 || fields[1] > SIZE_DEPTH+1)
+    return JSON_ERROR_INDEX;
+  index->level_count = (size_t)fields[1];
+  header += index->level_count*sizeof(uint64_t);
+  if (index->index_length < header || (index->index_length-header)%sizeof(json_index_record) != 0)
+    return JSON_ERROR_INDEX;
+  index->counts = fields+2;
+
+  index->levels = malloc(index->level_count*sizeof(*index->levels));
+  if (index->levels == NULL)
+    return JSON_ERROR_MEMORY;
+  const json_index_record *records = (const void*)(map+header);
+  size_t record_count = (index->index_length-header)/sizeof(json_index_record);
+  size_t total = 0;
+  for (size_t i=0; i<index->level_count; i++) {
+    if (index->counts[i] > record_count-total)
+      return JSON_ERROR_INDEX;
+    index->levels[i] = records+total;
+    total += (size_t)index->counts[i];
+  }
+  if (total != record_count || index->counts[0] != 1)
+    return JSON_ERROR_INDEX;
+  return JSON_ERROR_none_;
+}
+
+/*
+Compare the key at position in the text with a UTF-8 token.
+*/
+static bool index_key_equal(const char *text, size_t end, size_t position, const char *token, size_t token_length)
+{
+  /* '"' */
+  if (position >= end || text[position] != '"')
+    return false;
+  position++;
+
+  size_t matched = 0;
+  while (position < end && text[position] != '"') {
+    char encoded[4];
+    size_t encoded_length = 1;
+    if (text[position] == '\\') {
+      uint32_t code_point;
+      if (!text_escape(text, end, &position, &code_point))
+        return false;
+      encoded_length = utf8_encode(code_point, encoded);
+    } else {
+      encoded[0] = text[position++];
+    }
+    if (encoded_length > token_length-matched || memcmp(encoded, token+matched, encoded_length) != 0)
+      return false;
+    matched += encoded_length;
+  }
+  return position < end && matched == token_length;
+}
+
+/*
+Find a member or item of the container spanning [*start, *end) by skipping
+through its text, and narrow the span to it.
+*/
+static bool index_scan_child(const char *text, size_t *start, size_t *end, const char *token, size_t token_length, size_t item)
+{
+  char open = text[*start];
+  size_t position = *start+1;
+  for (size_t i=0; ; i++) {
+    text_skip_whitespace(text, *end, &position);
+    if (position >= *end || text[position] == ']' || text[position] == '}')
+      return false;
+    bool match;
+    if (open == '{') {
+      /* '"key":' */
+      match = index_key_equal(text, *end, position, token, token_length);
+      text_skip_string(text, *end, &position);
+      text_skip_whitespace(text, *end, &position);
+      if (position < *end && text[position] == ':')
+        position++;
+      text_skip_whitespace(text, *end, &position);
+    } else {
+      match = i == item;
+    }
+    size_t value = position;
+    text_skip_value(text, *end, &position);
+    if (match) {
+      *start = value;
+      *end = position;
+      return true;
+    }
+    text_skip_whitespace(text, *end, &position);
+    if (position >= *end || text[position] != ',')
+      return false;
+    position++;
+  }
+}
+
+/*
+*** Interface.
+*/
+
+json_error_type json_index_build(FILE *input, FILE *output, size_t depth)
+{
+  if (input == NULL || output == NULL)
+    return JSON_ERROR_FILE;
+  if (depth > SIZE_DEPTH)
+    return JSON_ERROR_RANGE;
+
+  index_builder ib = {
+    .input = input,
+    .buffer = malloc(SIZE_BUFFER),
+    .cursor = 0,
+    .end = 0,
+    .position = 0,
+    .level_count = depth+1,
+    .levels = calloc(depth+1, sizeof(*ib.levels)),
+    .counts = calloc(depth+1, sizeof(*ib.counts)),
+    .stack = malloc(SIZE_STACK*sizeof(*ib.stack)),
+    .stack_count = 0,
+    .stack_size = SIZE_STACK,
+    .error = JSON_ERROR_none_
+  };
+  if (ib.buffer == NULL || ib.levels == NULL || ib.counts == NULL || ib.stack == NULL) {
+    index_builder_free(&ib);
+    return JSON_ERROR_MEMORY;
+  }
+  for (size_t i=0; i<ib.level_count; i++) {
+    ib.levels[i] = tmpfile();
+    if (ib.levels[i] == NULL) {
+      index_builder_free(&ib);
+      return JSON_ERROR_FILE;
+    }
+  }
+
+  if (index_scan(&ib))
+    index_write(&ib, output);
+  index_builder_free(&ib);
+  return ib.error;
+}
+
+json_error_type json_index_open(const char *path, const char *index_path, json_index **index)
+{
+  /* Internal errors. */
+  assert(index != NULL);
+
+  *index = NULL;
+  if (path == NULL || index_path == NULL)
+    return JSON_ERROR_FILE;
+  json_index *opened = malloc(sizeof(*opened));
+  if (opened == NULL)
+    return JSON_ERROR_MEMORY;
+  *opened = (json_index){
+    .text_map = NULL,
+    .text_length = 0,
+    .index_map = NULL,
+    .index_length = 0,
+    .text = NULL,
+    .level_count = 0,
+    .counts = NULL,
+    .levels = NULL
+  };
+  if (!index_map(path, &opened->text_map, &opened->text_length) || !index_map(index_path, &opened->index_map, &opened->index_length)) {
+    json_index_close(opened);
+    return JSON_ERROR_FILE;
+  }
+  opened->text = opened->text_map;
+  /* Lookups jump around the input. */
+  posix_madvise(opened->text_map, opened->text_length, POSIX_MADV_RANDOM);
+
+  json_error_type error = index_check(opened);
+  if (error != JSON_ERROR_none_) {
+    json_index_close(opened);
+    return error;
+  }
+  *index = opened;
+  return JSON_ERROR_none_;
+}
+
+void json_index_close(json_index *index)
+{
+  assert(index != NULL);
+  if (index->text_map != NULL)
+    munmap(index->text_map, index->text_length);
+  if (index->index_map != NULL)
+    munmap(index->index_map, index->index_length);
+  free(index->levels);
+  free(index);
+}
+
+json_error_type json_index_find(json_index *index, const wchar_t *pointer, size_t *offset, size_t *length)
+{
+  /* Internal errors. */
+  assert(index != NULL);
+  assert(offset != NULL && length != NULL);
+
+  if (pointer == NULL || (*pointer != L'\0' && *pointer != L'/'))
+    return JSON_ERROR_PATH;
+  size_t pointer_length = wcslen(pointer);
+  wchar_t *token = malloc((pointer_length+1)*sizeof(*token));
+  char *encoded = malloc(pointer_length*4+1);
+  if (token == NULL || encoded == NULL) {
+    free(token);
+    free(encoded);
+    return JSON_ERROR_MEMORY;
+  }
+
+  const json_index_record *record = &index->levels[0][0];
+  size_t level = 0;
+  size_t start = (size_t)record->offset;
+  size_t end = start+(size_t)record->length;
+  json_error_type error = JSON_ERROR_none_;
+  if (record->offset >= index->text_length || record->length > index->text_length-record->offset)
+    error = JSON_ERROR_INDEX;
+  while (error == JSON_ERROR_none_ && *pointer == L'/') {
+    size_t token_length;
+    if (!pointer_token(&pointer, token) || !wcs_to_utf8(token, encoded, &token_length)) {
+      error = JSON_ERROR_PATH;
+      break;
+    }
+    char open = index->text[start];
+    if (open != '{' && open != '[') {
+      error = JSON_ERROR_MISSING;
+      break;
+    }
+    size_t item;
+    if (open != '[' || !pointer_index(token, &item))
+      item = SIZE_MAX;
+
+    if (record == NULL || level+1 >= index->level_count) {
+      /* Below the index: skip through the text. */
+      record = NULL;
+      if (!index_scan_child(index->text, &start, &end, encoded, token_length, item))
+        error = JSON_ERROR_MISSING;
+      continue;
+    }
+
+    /* Through the index. */
+    if (record->first_child > index->counts[level+1] || record->child_count > index->counts[level+1]-record->first_child) {
+      error = JSON_ERROR_INDEX;
+      break;
+    }
+    const json_index_record *children = index->levels[level+1]+record->first_child;
+    const json_index_record *child = NULL;
+    if (open == '[') {
+      if (item < record->child_count)
+        child = &children[item];
+    } else {
+      for (size_t i=0; i<record->child_count && child == NULL; i++)
+        if (children[i].key < index->text_length && index_key_equal(index->text, end, (size_t)children[i].key, encoded, token_length))
+          child = &children[i];
+    }
+    if (child == NULL) {
+      error = JSON_ERROR_MISSING;
+      break;
+    }
+    if (child->offset < start || child->offset >= end || child->length > end-child->offset) {
+      error = JSON_ERROR_INDEX;
+      break;
+    }
+    record = child;
+    level++;
+    start = (size_t)record->offset;
+    end = start+(size_t)record->length;
+  }
+  free(token);
+  free(encoded);
+
+  if (error == JSON_ERROR_none_) {
+    *offset = start;
+    *length = end-start;
+  }
+  return error;
+}
+
+json_value json_index_lookup(json_index *index, const wchar_t *pointer, json_parse_flags flags)
+{
+  size_t offset;
+  size_t length;
+  json_error_type error = json_index_find(index, pointer, &offset, &length);
+  if (error != JSON_ERROR_none_)
+    return VALUE_ERROR(error);
+
+  /* Parse only the addressed span. */
+  json_source *source = json_source_create_memory((const unsigned char*)index->text+offset, length);
+  if (source == NULL)
+    return VALUE_ERROR(JSON_ERROR_MEMORY);
+  json_parser_state *ps = json_parser_create(source, flags);
+  if (ps == NULL) {
+    json_source_destroy(source);
+    return VALUE_ERROR(JSON_ERROR_MEMORY);
+  }
+
+  json_value value = json_parse_value(ps);
+  if (ps->error == JSON_ERROR_none_) {
+    json_parse_whitespace(ps);
+    if (ps->wc != WEOF) {
+      json_value_free(value);
+      ps->error = JSON_ERROR_TRAILING;
+    }
+  }
+  if (ps->error != JSON_ERROR_none_)
+    value = VALUE_ERROR(json_parser_error(ps));
+
+  json_parser_destroy(ps);
+  json_source_destroy(source);
+  return value;
+}
@@ -0,0 +1,68 @@
+/*
+index.h - jsonparse
+Modified 2026-10-19
+*/
+
+#ifndef JSON_INDEX_H
+#define JSON_INDEX_H
+
+/* Header-specific includes. */
+#include "common.h"
+#include "structure.h"
+#include "errors.h"
+#include "parser.h"
+#include <stdint.h>
+#include <stdio.h>
+
+/*
+*** Interface.
+
+An index maps a JSON file too big to parse whole. json_index_build reads the
+file once and writes the byte span of every value down to the given depth,
+together with where the children of each container are listed; the root is at
+depth 0. The pass only follows brackets and strings, so values are validated
+when they are looked up.
+
+json_index_open maps the file and its index into memory. json_index_find
+resolves a JSON Pointer, such as L"/items/1024/name", to the byte span of its
+value: through the index as far as it reaches, then by skipping over the
+mapped text of the deepest indexed container. json_index_lookup parses only
+that span. An index belongs to the exact file it was built from, and is
+rejected if the file size no longer matches. Index files are written in host
+byte order, so they are not portable between machines; rebuild them instead of
+copying them.
+*/
+
+#include "index_public.h"
+
+/*
+Index file. A header of magic, input length and level count is followed by the
+record count of each level, then by the records of every level in turn. Each
+level lists the values at that depth in input order, so the children of a
+container are a run of records in the next level. Everything is stored as
+uint64_t in host byte order.
+*/
+
+#define JSON_INDEX_MAGIC "JSONIDX1"
+#define JSON_INDEX_NONE UINT64_MAX
+
+typedef struct json_index_record_ {
+  uint64_t offset;
+  uint64_t length;
+  uint64_t key; /* Offset of the key's '"', or JSON_INDEX_NONE in arrays. */
+  uint64_t first_child; /* Within the next level. */
+  uint64_t child_count;
+} json_index_record;
+
+struct json_index_ {
+  void *text_map;
+  size_t text_length;
+  void *index_map;
+  size_t index_length;
+  const char *text;
+  size_t level_count;
+  const uint64_t *counts;
+  const json_index_record **levels;
+};
+
+#endif /* !JSON_INDEX_H */
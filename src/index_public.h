@@ -0,0 +1,13 @@
+#ifndef JSON_INDEX_PUBLIC_H
+#define JSON_INDEX_PUBLIC_H
+
+typedef struct json_index_ json_index;
+
+json_error_type json_index_build(FILE *input, FILE *output, size_t depth);
+json_error_type json_index_open(const char *path, const char *index_path, json_index **index);
+void json_index_close(json_index *index);
+
+json_error_type json_index_find(json_index *index, const wchar_t *pointer, size_t *offset, size_t *length);
+json_value json_index_lookup(json_index *index, const wchar_t *pointer, json_parse_flags flags);
+
+#endif /* !JSON_INDEX_PUBLIC_H */
@@ -1,6 +1,6 @@
 /*
 parser.c - jsonparse
-Modified 2022-10-05
+Modified 2026-10-19
 */
 
 /* Header-specific includes. */
@@ -9,9 +9,14 @@ Modified 2022-10-05
 /* Implementation-specific includes. */
 #include "tools.h"
 #include <assert.h>
+#include <string.h>
 #include <wchar.h>
+#ifdef __SSE2__
+#include <immintrin.h>
+#endif
 
 /* Constants. */
+#define SIZE_BUFFER 65536
 #define SIZE_STRING 16
 #define SIZE_NUMBER 16
 #define SIZE_ARRAY 16
@@ -27,10 +32,10 @@ Modified 2022-10-05
 *** Interface.
 */
 
-json_parser_state *json_parser_create(FILE *stream)
+json_parser_state *json_parser_create(json_source *source, json_parse_flags flags)
 {
   /* Internal errors. */
-  assert(stream != NULL);
+  assert(source != NULL);
   
   /* Create parser state. */
   json_parser_state *ps = malloc(sizeof(*ps));
@@ -39,47 +44,251 @@ json_parser_state *json_parser_create(FILE *stream)
   
   /* Zero parser state. */
   *ps = (json_parser_state){
-    .stream = NULL,
+    .source = NULL,
+    .buffer = NULL,
+    .buffer_size = SIZE_BUFFER,
+    .cursor = NULL,
+    .end = NULL,
+    .text = NULL,
     .wc = WEOF,
+    .malformed = false,
+    .flags = flags,
     .error = JSON_ERROR_none_
   };
   
-  /* Store and prepare file stream. */
-  ps->stream = stream;
+  /* Allocate input buffer. */
+  ps->buffer = malloc(ps->buffer_size);
+  if (ps->buffer == NULL) {
+    free(ps);
+    return NULL;
+  }
+  ps->cursor = ps->end = ps->buffer;
+  
+  /* Store and prepare source. The source remains the caller's. */
+  ps->source = source;
   json_parser_advance(ps);
   
   /* Return parser state. This pointer acts as handle for outsiders. */
   return ps;
 }
 
+json_parser_state *json_parser_create_insitu(wchar_t *text, json_parse_flags flags)
+{
+  /* Internal errors. */
+  assert(text != NULL);
+  
+  /* Create parser state. */
+  json_parser_state *ps = malloc(sizeof(*ps));
+  if (ps == NULL)
+    return NULL;
+  
+  /* The text is read directly; no input buffer is needed. */
+  *ps = (json_parser_state){
+    .source = NULL,
+    .buffer = NULL,
+    .buffer_size = 0,
+    .cursor = NULL,
+    .end = NULL,
+    .text = text,
+    .wc = WEOF,
+    .malformed = false,
+    .flags = flags,
+    .error = JSON_ERROR_none_
+  };
+  json_parser_advance(ps);
+  
+  return ps;
+}
+
 void json_parser_destroy(json_parser_state *ps)
 {
   /* Internal errors. */
   assert(ps != NULL);
   
   /* Deallocate memory. */
+  free(ps->buffer);
   free(ps);
 }
 
+json_error_type json_parser_error(json_parser_state *ps)
+{
+  /* Internal errors. */
+  assert(ps != NULL);
+  
+  /* Unreadable or malformed input ends the character stream early; report the cause. */
+  if (ps->error != JSON_ERROR_none_ && ps->source != NULL && ps->source->error != JSON_ERROR_none_)
+    return ps->source->error;
+  if (ps->error != JSON_ERROR_none_ && ps->malformed)
+    return JSON_ERROR_ENCODING;
+  return ps->error;
+}
+
+/*
+Free what a failed parse leaves behind. In-situ strings belong to the text.
+*/
+void json_parser_discard(json_parser_state *ps, json_value value)
+{
+  if (ps->text != NULL)
+    json_value_free_insitu(value);
+  else
+    json_value_free(value);
+}
+
+static void json_parser_discard_string(json_parser_state *ps, wchar_t *string)
+{
+  if (ps->text == NULL)
+    free(string);
+}
+
+/*
+Move unread input to the start of the buffer and top it up from the source.
+Returns false if no new bytes could be read.
+*/
+static bool json_parser_fill(json_parser_state *ps)
+{
+  size_t remaining = (size_t)(ps->end-ps->cursor);
+  memmove(ps->buffer, ps->cursor, remaining);
+  size_t read = ps->source->read(ps->source, ps->buffer+remaining, ps->buffer_size-remaining);
+  ps->cursor = ps->buffer;
+  ps->end = ps->buffer+remaining+read;
+  return read > 0;
+}
+
+/*
+Decode and validate a multi-byte UTF-8 sequence at the cursor.
+*/
+static wint_t json_parser_decode(json_parser_state *ps)
+{
+  unsigned char lead = *ps->cursor;
+  size_t length;
+  uint32_t code_point;
+  uint32_t minimum;
+  if (lead >= 0xc2 && lead <= 0xdf) {
+    length = 2;
+    code_point = lead & 0x1f;
+    minimum = 0x80;
+  } else if (lead >= 0xe0 && lead <= 0xef) {
+    length = 3;
+    code_point = lead & 0x0f;
+    minimum = 0x800;
+  } else if (lead >= 0xf0 && lead <= 0xf4) {
+    length = 4;
+    code_point = lead & 0x07;
+    minimum = 0x10000;
+  } else {
+    ps->malformed = true;
+    return WEOF;
+  }
+  
+  /* The sequence may straddle the end of the buffer, and arrive piecemeal. */
+  while ((size_t)(ps->end-ps->cursor) < length)
+    if (!json_parser_fill(ps))
+      break;
+  if ((size_t)(ps->end-ps->cursor) < length) {
+    ps->malformed = true;
+    return WEOF;
+  }
+  
+  for (size_t i=1; i<length; i++) {
+    if ((ps->cursor[i] & 0xc0) != 0x80) {
+      ps->malformed = true;
+      return WEOF;
+    }
+    code_point = code_point << 6 | (ps->cursor[i] & 0x3f);
+  }
+  
+  /* Reject overlong forms, surrogates and code points beyond Unicode. */
+  if (code_point < minimum || (code_point >= 0xd800 && code_point <= 0xdfff) || code_point > 0x10ffff) {
+    ps->malformed = true;
+    return WEOF;
+  }
+  
+  ps->cursor += length;
+  return (wint_t)code_point;
+}
+
+/*
+Length of the run of plain string characters (printable ASCII other than '"'
+and '\\') starting at cursor.
+*/
+static size_t json_parser_scan_plain(const unsigned char *cursor, const unsigned char *end)
+{
+  const unsigned char *start = cursor;
+  
+  #ifdef __AVX2__
+  const __m256i quote_32 = _mm256_set1_epi8('"');
+  const __m256i backslash_32 = _mm256_set1_epi8('\\');
+  const __m256i space_32 = _mm256_set1_epi8(' ');
+  while (end-cursor >= 32) {
+    __m256i chunk = _mm256_loadu_si256((const __m256i*)(const void*)cursor);
+    /* Signed comparison flags both control characters and non-ASCII bytes. */
+    __m256i special = _mm256_or_si256(
+      _mm256_or_si256(_mm256_cmpeq_epi8(chunk, quote_32), _mm256_cmpeq_epi8(chunk, backslash_32)),
+      _mm256_cmpgt_epi8(space_32, chunk)
+    );
+    unsigned mask = (unsigned)_mm256_movemask_epi8(special);
+    if (mask != 0)
+      return (size_t)(cursor-start)+(size_t)__builtin_ctz(mask);
+    cursor += 32;
+  }
+  #endif
+  
+  #ifdef __SSE2__
+  const __m128i quote = _mm_set1_epi8('"');
+  const __m128i backslash = _mm_set1_epi8('\\');
+  const __m128i space = _mm_set1_epi8(' ');
+  while (end-cursor >= 16) {
+    __m128i chunk = _mm_loadu_si128((const __m128i*)(const void*)cursor);
+    /* Signed comparison flags both control characters and non-ASCII bytes. */
+    __m128i special = _mm_or_si128(
+      _mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)),
+      _mm_cmplt_epi8(chunk, space)
+    );
+    unsigned mask = (unsigned)_mm_movemask_epi8(special);
+    if (mask != 0)
+      return (size_t)(cursor-start)+(size_t)__builtin_ctz(mask);
+    cursor += 16;
+  }
+  #endif
+  
+  while (cursor < end && *cursor >= 0x20 && *cursor < 0x80 && *cursor != '"' && *cursor != '\\')
+    cursor++;
+  return (size_t)(cursor-start);
+}
+
 void json_parser_advance(json_parser_state *ps)
 {
   /* Internal errors. */
   assert(ps != NULL);
-  assert(ps->stream != NULL);
+  assert(ps->source != NULL || ps->text != NULL);
   
   #ifdef JSON_PARSER_PRINT_PARSED_CHARACTERS
   wprintf(L"%c", ps->wc);
   #endif
   
+  /* In-situ text. */
+  if (ps->text != NULL) {
+    ps->wc = *ps->text != L'\0' ? (wint_t)*ps->text++ : WEOF;
+    return;
+  }
+  
   /* Get next character. */
-  ps->wc = fgetwc(ps->stream);
+  if (ps->cursor == ps->end && !json_parser_fill(ps)) {
+    ps->wc = WEOF;
+    return;
+  }
+  if (*ps->cursor < 0x80) {
+    ps->wc = *ps->cursor++;
+    return;
+  }
+  ps->wc = json_parser_decode(ps);
 }
 
 void json_parse_whitespace(json_parser_state *ps)
 {
   /* Internal errors. */
   assert(ps != NULL);
-  assert(ps->stream != NULL);
+  assert(ps->source != NULL || ps->text != NULL);
   
   /* Advance until next non-whitespace character. */
   while (CHARACTER_IS_WHITESPACE(ps->wc))
@@ -90,7 +299,7 @@ bool json_parse_character(json_parser_state *ps, wchar_t wc)
 {
   /* Internal errors. */
   assert(ps != NULL);
-  assert(ps->stream != NULL);
+  assert(ps->source != NULL || ps->text != NULL);
   
   /* Advance if current character matches. */
   if (ps->wc != (wint_t)wc)
@@ -103,7 +312,7 @@ bool json_parse_literal(json_parser_state *ps, wchar_t *literal)
 {
   /* Internal errors. */
   assert(ps != NULL);
-  assert(ps->stream != NULL);
+  assert(ps->source != NULL || ps->text != NULL);
   assert(literal != NULL);
   
   /* Advance past literal or return early in case of failure. */
@@ -113,11 +322,54 @@ bool json_parse_literal(json_parser_state *ps, wchar_t *literal)
   return true;
 }
 
+/*
+Wrap the text of a number in a JSON_TYPE_NUMBER value. Consumes buffer.
+*/
+static json_value json_parse_number_lazy(json_parser_state *ps, wchar_t *buffer, size_t length, json_type hint)
+{
+  json_value value = {
+    .type = JSON_TYPE_none_,
+    .as.integer = 0
+  };
+  json_number *number = json_number_create(hint, buffer, length);
+  free(buffer);
+  if (number == NULL) {
+    ps->error = JSON_ERROR_MEMORY;
+    return value;
+  }
+  value = (json_value){
+    .type = JSON_TYPE_NUMBER,
+    .as.number = number
+  };
+  return value;
+}
+
+/*
+Append the current character to the text of a number and advance.
+*/
+static bool json_parse_number_take(json_parser_state *ps, wchar_t **buffer, size_t *buffer_idx, size_t *buffer_size)
+{
+  /* Ensure sufficient space in buffer. */
+  while (*buffer_idx+1 /* NUL. */ >= *buffer_size) {
+    wchar_t *buffer_new = realloc(*buffer, 2*(*buffer_size)*sizeof(**buffer));
+    if (buffer_new == NULL) {
+      ps->error = JSON_ERROR_MEMORY;
+      return false;
+    }
+    *buffer = buffer_new;
+    *buffer_size *= 2;
+  }
+  /* Add character to buffer. */
+  (*buffer)[(*buffer_idx)++] = (wchar_t)ps->wc;
+  json_parser_advance(ps);
+  return true;
+}
+
 json_value json_parse_number(json_parser_state *ps)
 {
    /* Internal errors. */
   assert(ps != NULL);
-  assert(ps->stream != NULL);
+  assert(ps->source != NULL || ps->text != NULL);
   
   /* Prepare. */
   json_value value = {
@@ -132,27 +384,67 @@ json_value json_parse_number(json_parser_state *ps)
     return value;
   }
   
-  /* Read number as string. */
+  /* Read sign and integer digits. */
   do {
-    /* Ensure sufficient space in buffer. */
-    while (buffer_idx+1 /* NUL. */ >= buffer_size) {
-      buffer_size *= 2;
-      wchar_t *buffer_new = realloc(buffer, buffer_size*sizeof(*buffer));
-      if (buffer_new == NULL) {
+    if (!json_parse_number_take(ps, &buffer, &buffer_idx, &buffer_size)) {
+      free(buffer);
+      return value;
+    }
+  } while (CHARACTER_IS_DIGIT(ps->wc));
+  bool integral = true;
+  /* A lone sign is no number, whatever follows it. */
+  if (!CHARACTER_IS_DIGIT(buffer[buffer_idx-1])) {
+    ps->error = ps->wc == L'.' || ps->wc == L'e' || ps->wc == L'E' ? JSON_ERROR_FLOATING : JSON_ERROR_INTEGER;
+    free(buffer);
+    return value;
+  }
+  
+  /* Read decimal point and decimal digits. */
+  if (ps->wc == L'.') {
+    integral = false;
+    size_t idx_before_decimals = buffer_idx+1;
+    do {
+      if (!json_parse_number_take(ps, &buffer, &buffer_idx, &buffer_size)) {
         free(buffer);
-        ps->error = JSON_ERROR_MEMORY;
         return value;
       }
-      buffer = buffer_new;
+    } while (CHARACTER_IS_DIGIT(ps->wc));
+    /* No digits after decimal point. */
+    if (buffer_idx == idx_before_decimals) {
+      ps->error = JSON_ERROR_FLOATING;
+      free(buffer);
+      return value;
     }
-    /* Add character to buffer. */
-    buffer[buffer_idx++] = (wchar_t)ps->wc;
-    json_parser_advance(ps);
-  } while (CHARACTER_IS_DIGIT(ps->wc));
+  }
   
-  if (ps->wc != L'.') {
+  /* Read exponent. */
+  if (ps->wc == L'e' || ps->wc == L'E') {
+    integral = false;
+    if (!json_parse_number_take(ps, &buffer, &buffer_idx, &buffer_size) || ((ps->wc == L'+' || ps->wc == L'-') && !json_parse_number_take(ps, &buffer, &buffer_idx, &buffer_size))) {
+      free(buffer);
+      return value;
+    }
+    size_t idx_before_exponent = buffer_idx;
+    while (CHARACTER_IS_DIGIT(ps->wc)) {
+      if (!json_parse_number_take(ps, &buffer, &buffer_idx, &buffer_size)) {
+        free(buffer);
+        return value;
+      }
+    }
+    /* No digits in exponent. */
+    if (buffer_idx == idx_before_exponent) {
+      ps->error = JSON_ERROR_FLOATING;
+      free(buffer);
+      return value;
+    }
+  }
+  buffer[buffer_idx] = L'\0';
+  
+  if (integral) {
+    /* Keep the text for later conversion. */
+    if (ps->flags & JSON_PARSE_LAZY_NUMBERS)
+      return json_parse_number_lazy(ps, buffer, buffer_idx, JSON_TYPE_INTEGER);
     /* Return integer. */
-    buffer[buffer_idx] = L'\0';
     json_integer integer;
     if (!wcs_to_json_integer(buffer, &integer))
       ps->error = JSON_ERROR_INTEGER;
@@ -165,41 +457,9 @@ json_value json_parse_number(json_parser_state *ps)
     return value;
   }
   
-  /* Try to parse floating point number. */
-  
-  /* Skip decimal point. */
-  buffer[buffer_idx++] = (wchar_t)ps->wc; /* '.' */
-  json_parser_advance(ps);
-  
-  size_t idx_before_decimals = buffer_idx;
-  
-  /* Read decimal digits. */
-  while (CHARACTER_IS_DIGIT(ps->wc)) {
-    /* Ensure sufficient space in buffer. */
-    while (buffer_idx+1 /* NUL. */ >= buffer_size) {
-      buffer_size *= 2;
-      wchar_t *buffer_new = realloc(buffer, buffer_size*sizeof(*buffer));
-      if (buffer_new == NULL) {
-        free(buffer);
-        ps->error = JSON_ERROR_MEMORY;
-        return value;
-      }
-      buffer = buffer_new;
-    }
-    /* Add character to buffer. */
-    buffer[buffer_idx++] = (wchar_t)ps->wc;
-    json_parser_advance(ps);
-  }
-  
-  /* No digits after decimal point. */
-  if (buffer_idx == idx_before_decimals) {
-    ps->error = JSON_ERROR_FLOATING;
-    free(buffer);
-    return value;
-  }
-  
   /* Return floating point number. */
-  buffer[buffer_idx] = L'\0';
+  if (ps->flags & JSON_PARSE_LAZY_NUMBERS)
+    return json_parse_number_lazy(ps, buffer, buffer_idx, JSON_TYPE_FLOATING);
   json_floating floating;
   if (!wcs_to_json_floating(buffer, &floating))
     ps->error = JSON_ERROR_FLOATING;
@@ -212,11 +472,97 @@ json_value json_parse_number(json_parser_state *ps)
   return value;
 }
 
+/*
+Read the four hexadecimal digits of a '\\uXXXX' escape, starting at the current
+character. Returns false if they are malformed.
+*/
+static bool json_parse_hex4(json_parser_state *ps, uint32_t *dest)
+{
+  uint32_t code_unit = 0;
+  for (int i=0; i<4; i++) {
+    int digit = ps->wc != WEOF ? hex_digit((uint32_t)ps->wc) : -1;
+    if (digit < 0)
+      return false;
+    code_unit = code_unit << 4 | (uint32_t)digit;
+    json_parser_advance(ps);
+  }
+  *dest = code_unit;
+  return true;
+}
+
+/*
+Decode the escape sequence following a '\\'. The current character is the
+one after the backslash. Returns WEOF if the sequence is illegal.
+*/
+static wint_t json_parse_escape(json_parser_state *ps)
+{
+  if (ps->wc == L'u') {
+    json_parser_advance(ps);
+    uint32_t code_point;
+    if (!json_parse_hex4(ps, &code_point) || code_point == 0 || (code_point >= 0xdc00 && code_point <= 0xdfff))
+      return WEOF;
+    /* A high surrogate must be followed by an escaped low surrogate. */
+    if (code_point >= 0xd800 && code_point <= 0xdbff) {
+      uint32_t low;
+      if (!json_parse_character(ps, L'\\') || !json_parse_character(ps, L'u') || !json_parse_hex4(ps, &low) || low < 0xdc00 || low > 0xdfff)
+        return WEOF;
+      code_point = 0x10000+((code_point-0xd800) << 10)+(low-0xdc00);
+    }
+    /* The hexadecimal digits have been consumed already. */
+    return (wint_t)code_point;
+  }
+  uint32_t character = ps->wc != WEOF ? escape_character((uint32_t)ps->wc) : 0;
+  if (character == 0)
+    return WEOF;
+  json_parser_advance(ps);
+  return (wint_t)character;
+}
+
+/*
+Unescape the rest of a string in place, right where it starts in the text. The
+result is never longer than its source, so writing trails reading; the closing
+'"' makes room for the NUL.
+*/
+static wchar_t *json_parse_string_insitu(json_parser_state *ps)
+{
+  wchar_t *string = ps->text-1; /* Current character. */
+  wchar_t *string_end = string;
+  
+  /* 'string' */
+  while (ps->wc != L'"' && ps->wc != WEOF) {
+    wint_t wc = ps->wc;
+    if (wc < 0x20) {
+      ps->error = JSON_ERROR_STRINGCONTROL;
+      return NULL;
+    }
+    json_parser_advance(ps);
+    /* Handle character escapes. */
+    if (wc == L'\\') {
+      wc = json_parse_escape(ps);
+      if (wc == WEOF) {
+        ps->error = JSON_ERROR_STRINGESCAPE;
+        return NULL;
+      }
+    }
+    *string_end++ = (wchar_t)wc;
+  }
+  
+  /* '"' */
+  if (!json_parse_character(ps, L'"')) {
+    ps->error = JSON_ERROR_STRINGCLOSE;
+    return NULL;
+  }
+  
+  /* Terminate string. */
+  *string_end = L'\0';
+  return string;
+}
+
 wchar_t *json_parse_string(json_parser_state *ps)
 {
   /* Internal errors. */
   assert(ps != NULL);
-  assert(ps->stream != NULL);
+  assert(ps->source != NULL || ps->text != NULL);
   
   /* Whitespace. */
   json_parse_whitespace(ps);
@@ -226,6 +572,8 @@ wchar_t *json_parse_string(json_parser_state *ps)
     ps->error = JSON_ERROR_STRINGOPEN;
     return NULL;
   }
+  if (ps->text != NULL)
+    return json_parse_string_insitu(ps);
   
   /* Allocate string. */
   size_t string_size = SIZE_STRING;
@@ -238,8 +586,35 @@ wchar_t *json_parse_string(json_parser_state *ps)
   
   /* 'string' */
   while (ps->wc != L'"' && ps->wc != WEOF) {
+    /* Control characters must be escaped. */
+    wint_t wc = ps->wc;
+    if (wc < 0x20) {
+      ps->error = JSON_ERROR_STRINGCONTROL;
+      free(string);
+      return NULL;
+    }
+    /* Handle character escapes. */
+    if (wc == L'\\') {
+      json_parser_advance(ps);
+      wc = json_parse_escape(ps);
+      if (wc == WEOF) {
+        ps->error = JSON_ERROR_STRINGESCAPE;
+        free(string);
+        return NULL;
+      }
+    } else {
+      json_parser_advance(ps);
+    }
+    
+    /* Plain characters that follow in the buffer are taken in bulk. */
+    size_t plain = 0;
+    #ifndef JSON_PARSER_PRINT_PARSED_CHARACTERS
+    if (ps->wc >= 0x20 && ps->wc < 0x80 && ps->wc != L'"' && ps->wc != L'\\')
+      plain = json_parser_scan_plain(ps->cursor, ps->end);
+    #endif
+    
     /* Ensure buffer is big enough. */
-    while (string_idx+1 >= string_size) {
+    while (string_idx+2 /* Character and current character. */ +plain+1 /* NUL. */ > string_size) {
       string_size *= 2;
       wchar_t *string_new = realloc(string, string_size*sizeof(*string));
       if (string_new == NULL) {
@@ -249,25 +624,16 @@ wchar_t *json_parse_string(json_parser_state *ps)
       }
       string = string_new;
     }
-    /* Handle character escapes. */
-    if (ps->wc == L'\\') {
+    
+    /* Accept character. */
+    string[string_idx++] = (wchar_t)wc;
+    if (plain > 0) {
+      string[string_idx++] = (wchar_t)ps->wc;
+      for (size_t i=0; i<plain; i++)
+        string[string_idx++] = (wchar_t)ps->cursor[i];
+      ps->cursor += plain;
       json_parser_advance(ps);
-      switch (ps->wc) {
-        case L'"':
-        case L'\\':
-          break;
-        case L'n':
-          ps->wc = L'\n';
-          break;
-        default:
-          ps->error = JSON_ERROR_STRINGESCAPE;
-          free(string);
-          return NULL;
-      }
     }
-    /* Accept character. */
-    string[string_idx++] = (wchar_t)ps->wc;
-    json_parser_advance(ps);
   }
   /* Terminate string. */
   string[string_idx] = L'\0';
@@ -286,7 +652,7 @@ json_value json_parse_value(json_parser_state *ps)
 {
    /* Internal errors. */
   assert(ps != NULL);
-  assert(ps->stream != NULL);
+  assert(ps->source != NULL || ps->text != NULL);
   
   /* Whitespace. */
   json_parse_whitespace(ps);
@@ -354,7 +720,7 @@ json_pair json_parse_pair(json_parser_state *ps)
 {
    /* Internal errors. */
   assert(ps != NULL);
-  assert(ps->stream != NULL);
+  assert(ps->source != NULL || ps->text != NULL);
   
   /* Prepare. */
   json_pair pair = {
@@ -376,14 +742,14 @@ json_pair json_parse_pair(json_parser_state *ps)
   /* ':' */
   if (!json_parse_character(ps, L':')) {
     ps->error = JSON_ERROR_PAIRSEPERATOR;
-    free(key);
+    json_parser_discard_string(ps, key);
     return pair;
   }
   
   /* 'value' */
   json_value value = json_parse_value(ps);
   if (ps->error != JSON_ERROR_none_) {
-    free(key);
+    json_parser_discard_string(ps, key);
     return pair;
   }
   
@@ -392,11 +758,67 @@ json_pair json_parse_pair(json_parser_state *ps)
   return pair;
 }
 
+/*
+Append a number to a packed array of its type. Fails without consuming the item
+if it does not fit the array or memory runs out.
+*/
+static bool json_parse_array_pack(json_value *packed, size_t *packed_size, json_value item)
+{
+  if (packed->type == JSON_TYPE_INTEGER_ARRAY && item.type != JSON_TYPE_INTEGER)
+    return false;
+  if (packed->type == JSON_TYPE_FLOATING_ARRAY && item.type != JSON_TYPE_FLOATING)
+    return false;
+  if (!JSON_TYPE_IS_PACKED(packed->type))
+    return false;
+  
+  /* Grow. */
+  if (packed->as.packed.count >= *packed_size) {
+    size_t item_size = packed->type == JSON_TYPE_INTEGER_ARRAY ? sizeof(json_integer) : sizeof(json_floating);
+    size_t packed_size_new = *packed_size > 0 ? 2*(*packed_size) : SIZE_ARRAY;
+    void *items_new = realloc(packed->as.packed.items, packed_size_new*item_size);
+    if (items_new == NULL)
+      return false;
+    packed->as.packed.items = items_new;
+    *packed_size = packed_size_new;
+  }
+  
+  if (item.type == JSON_TYPE_INTEGER)
+    ((json_integer *)packed->as.packed.items)[packed->as.packed.count++] = item.as.integer;
+  else
+    ((json_floating *)packed->as.packed.items)[packed->as.packed.count++] = item.as.floating;
+  return true;
+}
+
+/*
+Move the items of a packed array into an empty regular array. Consumes packed.
+*/
+static bool json_parse_array_unpack(json_value *packed, json_value *array, size_t *array_size)
+{
+  size_t count = packed->as.packed.count;
+  if (1+count+1 > *array_size) {
+    json_value *array_new = realloc(array->as.array, (1+count+1)*sizeof(*array->as.array));
+    if (array_new == NULL) {
+      free(packed->as.packed.items);
+      packed->as.packed.items = NULL;
+      return false;
+    }
+    array->as.array = array_new;
+    *array_size = 1+count+1;
+  }
+  for (size_t i=0; i<count; i++)
+    array->as.array[1+i] = json_value_array_item(*packed, i);
+  array->as.array[0].as.integer = (json_integer)count;
+  free(packed->as.packed.items);
+  packed->as.packed.items = NULL;
+  packed->as.packed.count = 0;
+  return true;
+}
+
 json_value json_parse_array(json_parser_state *ps)
 {
    /* Internal errors. */
   assert(ps != NULL);
-  assert(ps->stream != NULL);
+  assert(ps->source != NULL || ps->text != NULL);
   
   /* Prepare array. */
   size_t array_size = SIZE_ARRAY;
@@ -431,24 +853,55 @@ json_value json_parse_array(json_parser_state *ps)
   
   /* Items. */
   json_value item;
+  json_value packed = {
+    .type = JSON_TYPE_none_,
+    .as.packed = (json_packed){
+      .count = 0,
+      .items = NULL
+    }
+  };
+  size_t packed_size = 0;
+  bool packing = ps->flags & JSON_PARSE_PACKED_ARRAYS;
   while (ps->wc != L']') {
+    /* Parse value. */
+    item = json_parse_value(ps);
+    if (ps->error != JSON_ERROR_none_) {
+      free(packed.as.packed.items);
+      json_parser_discard(ps, value);
+      return value;
+    }
+    /* Pack numbers while they all share one type. */
+    if (packing) {
+      if (packed.type == JSON_TYPE_none_ && (item.type == JSON_TYPE_INTEGER || item.type == JSON_TYPE_FLOATING))
+        packed.type = item.type == JSON_TYPE_INTEGER ? JSON_TYPE_INTEGER_ARRAY : JSON_TYPE_FLOATING_ARRAY;
+      if (json_parse_array_pack(&packed, &packed_size, item)) {
+        json_parse_whitespace(ps);
+        if (!json_parse_character(ps, L','))
+          break;
+        continue;
+      }
+      /* Mixed items: fall back to a regular array. */
+      packing = false;
+      if (!json_parse_array_unpack(&packed, &value, &array_size)) {
+        ps->error = JSON_ERROR_MEMORY;
+        json_parser_discard(ps, item);
+        json_parser_discard(ps, value);
+        return value;
+      }
+      array_idx = 1+(size_t)value.as.array[0].as.integer;
+    }
     /* Ensure array is big enough. */
     while (array_idx >= array_size) {
       array_size *= 2;
       json_value *array_new = realloc(value.as.array, array_size*sizeof(*value.as.array));
       if (array_new == NULL) {
         ps->error = JSON_ERROR_MEMORY;
-        json_value_free(value);
+        json_parser_discard(ps, item);
+        json_parser_discard(ps, value);
         return value;
       }
       value.as.array = array_new;
     }
-    /* Parse value. */
-    item = json_parse_value(ps);
-    if (ps->error != JSON_ERROR_none_) {
-      json_value_free(value);
-      return value;
-    }
     value.as.array[0].as.integer = (json_integer)array_idx;
     value.as.array[array_idx++] = item;
     /* Whitespace. */
@@ -461,7 +914,15 @@ json_value json_parse_array(json_parser_state *ps)
   /* ']' */
   if (!json_parse_character(ps, L']')) {
     ps->error = JSON_ERROR_ARRAYCLOSE;
-    json_value_free(value);
+    free(packed.as.packed.items);
+    json_parser_discard(ps, value);
+    return value;
+  }
+  
+  /* Replace the empty regular array by the packed one. */
+  if (packing && packed.as.packed.count > 0) {
+    json_parser_discard(ps, value);
+    return packed;
   }
   
   return value;
@@ -471,7 +932,7 @@ json_value json_parse_object(json_parser_state *ps)
 {
    /* Internal errors. */
   assert(ps != NULL);
-  assert(ps->stream != NULL);
+  assert(ps->source != NULL || ps->text != NULL);
   
   /* Prepare object. */
   size_t object_size = SIZE_OBJECT;
@@ -494,7 +955,7 @@ json_value json_parse_object(json_parser_state *ps)
   /* '{' */
   if (!json_parse_character(ps, L'{')) {
     ps->error = JSON_ERROR_OBJECTOPEN;
-    json_value_free(value);
+    json_parser_discard(ps, value);
     return value;
   }
   
@@ -510,7 +971,7 @@ json_value json_parse_object(json_parser_state *ps)
       json_pair *pairs_new = realloc(value.as.object.pairs, object_size*sizeof(*value.as.object.pairs));
       if (pairs_new == NULL) {
         ps->error = JSON_ERROR_MEMORY;
-        json_value_free(value);
+        json_parser_discard(ps, value);
         return value;
       }
       value.as.object.pairs = pairs_new;
@@ -518,7 +979,7 @@ json_value json_parse_object(json_parser_state *ps)
     /* Parse pair. */
     pair = json_parse_pair(ps);
     if (ps->error != JSON_ERROR_none_) {
-      json_value_free(value);
+      json_parser_discard(ps, value);
       return value;
     }
     value.as.object.pairs[object_idx++] = pair;
@@ -533,7 +994,7 @@ json_value json_parse_object(json_parser_state *ps)
   /* '}' */
   if (!json_parse_character(ps, L'}')) {
     ps->error = JSON_ERROR_OBJECTCLOSE;
-    json_value_free(value);
+    json_parser_discard(ps, value);
   }
   
   return value;
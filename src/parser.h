@@ -1,6 +1,6 @@
 /*
 parser.h - jsonparse
-Modified 2022-10-05
+Modified 2026-10-19
 */
 
 #ifndef JSON_PARSER_H
@@ -11,14 +11,24 @@ Modified 2022-10-05
 #include <wchar.h>
 #include "common.h"
 #include "errors.h"
+#include "source.h"
 
 /*
 Parser state.
 */
 
+#include "parser_public.h"
+
 typedef struct json_parser_state_ {
-  FILE *stream;
+  json_source *source;
+  unsigned char *buffer;
+  size_t buffer_size;
+  unsigned char *cursor;
+  unsigned char *end;
+  wchar_t *text; /* In-situ input, instead of a source. */
   wint_t wc;
+  bool malformed;
+  json_parse_flags flags;
   json_error_type error;
 } json_parser_state;
 
@@ -26,8 +36,11 @@ typedef struct json_parser_state_ {
 *** Interface.
 */
 
-json_parser_state *json_parser_create(FILE *stream);
+json_parser_state *json_parser_create(json_source *source, json_parse_flags flags);
+json_parser_state *json_parser_create_insitu(wchar_t *text, json_parse_flags flags);
 void json_parser_destroy(json_parser_state *ps);
+json_error_type json_parser_error(json_parser_state *ps);
+void json_parser_discard(json_parser_state *ps, json_value value);
 
 void json_parser_advance(json_parser_state *ps);
 void json_parse_whitespace(json_parser_state *ps);
@@ -0,0 +1,17 @@
+#ifndef JSON_PARSER_PUBLIC_H
+#define JSON_PARSER_PUBLIC_H
+
+/*
+Parse flags. With JSON_PARSE_READAHEAD, a background thread reads up to a few
+MiB ahead of the parser; afterwards the position of the stream is undefined.
+Streams on pipes, sockets and terminals are read through their descriptor, so
+nothing may be left in their stdio buffer from earlier reads.
+*/
+typedef enum json_parse_flags_ {
+  JSON_PARSE_DEFAULT = 0,
+  JSON_PARSE_LAZY_NUMBERS = 1 << 0,
+  JSON_PARSE_READAHEAD = 1 << 1,
+  JSON_PARSE_PACKED_ARRAYS = 1 << 2
+} json_parse_flags;
+
+#endif /* !JSON_PARSER_PUBLIC_H */
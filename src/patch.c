@@ -0,0 +1,683 @@
+/*
+patch.c - jsonparse
+Modified 2026-10-19
+*/
+
+/* Header-specific includes. */
+#include "patch.h"
+
+/* Implementation-specific includes. */
+#include "builder.h"
+#include "hash.h"
+#include "tools.h"
+#include <assert.h>
+#include <string.h>
+#include <wchar.h>
+
+/* Constants. */
+#define SIZE_LINEAR 8 /* Objects up to this size are matched by scanning. */
+#define SIZE_PATH 64
+#define SIZE_INDEX 24
+
+/* Helpers. */
+#define VALUE_ERROR(error) \
+  ((json_value){ .type = JSON_TYPE_ERROR, .as.integer = error })
+#define VALUE_NULL \
+  ((json_value){ .type = JSON_TYPE_NULL, .as.integer = 0 })
+#define VALUE_NONE \
+  ((json_value){ .type = JSON_TYPE_none_, .as.integer = 0 })
+
+/*
+*** Pointers.
+*/
+
+static size_t object_find(json_object object, size_t start, size_t end, const wchar_t *key)
+{
+  for (size_t i=start; i<end; i++)
+    if (wcscmp(object.pairs[i].key, key) == 0)
+      return i;
+  return JSON_KEY_INDEX_NONE;
+}
+
+/*
+*** Diff.
+*/
+
+typedef struct diff_state_ {
+  json_builder patch;
+  wchar_t *path;
+  size_t path_length;
+  size_t path_size;
+  json_error_type error;
+} diff_state;
+
+static bool diff_fail(diff_state *ds, json_error_type error)
+{
+  if (ds->error == JSON_ERROR_none_)
+    ds->error = error;
+  return false;
+}
+
+/*
+Append an escaped reference token to the path.
+*/
+static bool diff_push(diff_state *ds, const wchar_t *token)
+{
+  /* Ensure path is big enough. */
+  size_t length = ds->path_length+1+2*wcslen(token);
+  if (length+1 /* NUL. */ > ds->path_size) {
+    size_t path_size = ds->path_size;
+    while (length+1 > path_size)
+      path_size *= 2;
+    wchar_t *path_new = realloc(ds->path, path_size*sizeof(*path_new));
+    if (path_new == NULL)
+      return diff_fail(ds, JSON_ERROR_MEMORY);
+    ds->path = path_new;
+    ds->path_size = path_size;
+  }
+  
+  ds->path[ds->path_length++] = L'/';
+  for (; *token != L'\0'; token++) {
+    if (*token == L'~' || *token == L'/') {
+      ds->path[ds->path_length++] = L'~';
+      ds->path[ds->path_length++] = *token == L'~' ? L'0' : L'1';
+    } else {
+      ds->path[ds->path_length++] = *token;
+    }
+  }
+  ds->path[ds->path_length] = L'\0';
+  return true;
+}
+
+static bool diff_push_index(diff_state *ds, size_t index)
+{
+  wchar_t token[SIZE_INDEX];
+  swprintf(token, SIZE_INDEX, L"%zu", index);
+  return diff_push(ds, token);
+}
+
+static void diff_pop(diff_state *ds, size_t length)
+{
+  ds->path_length = length;
+  ds->path[length] = L'\0';
+}
+
+static bool diff_append_string(json_builder *builder, wchar_t *key, wchar_t *string)
+{
+  wchar_t *key_copy = wcs_duplicate(key);
+  wchar_t *string_copy = wcs_duplicate(string);
+  if (key_copy == NULL || string_copy == NULL) {
+    free(key_copy);
+    free(string_copy);
+    return false;
+  }
+  return json_builder_append(builder, key_copy, (json_value){
+    .type = JSON_TYPE_STRING,
+    .as.string = string_copy
+  });
+}
+
+/*
+Add an operation on the current path. value is copied, unless it is
+JSON_TYPE_none_ for operations without one.
+*/
+static bool diff_emit(diff_state *ds, wchar_t *op, json_value value)
+{
+  json_builder operation;
+  if (!json_builder_object(&operation, NULL, 3))
+    return diff_fail(ds, JSON_ERROR_MEMORY);
+  bool built = diff_append_string(&operation, L"op", op) && diff_append_string(&operation, L"path", ds->path);
+  if (built && value.type != JSON_TYPE_none_) {
+    wchar_t *key = wcs_duplicate(L"value");
+    json_value copy = json_value_clone(value);
+    if (key == NULL || copy.type == JSON_TYPE_ERROR) {
+      free(key);
+      if (copy.type != JSON_TYPE_ERROR)
+        json_value_free(copy);
+      built = false;
+    } else {
+      built = json_builder_append(&operation, key, copy);
+    }
+  }
+  if (!built) {
+    json_builder_discard(&operation);
+    return diff_fail(ds, JSON_ERROR_MEMORY);
+  }
+  if (!json_builder_push(&ds->patch, json_builder_finish(&operation)))
+    return diff_fail(ds, JSON_ERROR_MEMORY);
+  return true;
+}
+
+static bool diff_value(diff_state *ds, json_value a, json_value b);
+
+static bool diff_object(diff_state *ds, json_object a, json_object b)
+{
+  bool *matched = calloc(b.pair_count > 0 ? b.pair_count : 1, sizeof(*matched));
+  if (matched == NULL)
+    return diff_fail(ds, JSON_ERROR_MEMORY);
+  json_key_index index;
+  bool indexed = b.pair_count > SIZE_LINEAR && json_key_index_create(&index, b);
+  
+  /* Members of a are changed in place or removed. */
+  size_t length = ds->path_length;
+  bool diffed = true;
+  for (size_t i=0; i<a.pair_count && diffed; i++) {
+    wchar_t *key = a.pairs[i].key;
+    size_t j = indexed ? json_key_index_find(&index, key) : object_find(b, 0, b.pair_count, key);
+    diffed = diff_push(ds, key);
+    if (diffed && j == JSON_KEY_INDEX_NONE) {
+      diffed = diff_emit(ds, L"remove", VALUE_NONE);
+    } else if (diffed) {
+      matched[j] = true;
+      diffed = diff_value(ds, a.pairs[i].value, b.pairs[j].value);
+    }
+    diff_pop(ds, length);
+  }
+  
+  /* Members only in b are added. */
+  for (size_t j=0; j<b.pair_count && diffed; j++) {
+    if (matched[j])
+      continue;
+    diffed = diff_push(ds, b.pairs[j].key) && diff_emit(ds, L"add", b.pairs[j].value);
+    diff_pop(ds, length);
+  }
+  
+  if (indexed)
+    json_key_index_destroy(&index);
+  free(matched);
+  return diffed;
+}
+
+static bool diff_array(diff_state *ds, json_value a, json_value b)
+{
+  size_t a_length = json_value_array_length(a);
+  size_t b_length = json_value_array_length(b);
+  
+  /* Only what lies between the common head and tail can differ. */
+  size_t head = 0;
+  while (head < a_length && head < b_length && json_value_equal(json_value_array_item(a, head), json_value_array_item(b, head)))
+    head++;
+  size_t tail = 0;
+  while (tail < a_length-head && tail < b_length-head && json_value_equal(json_value_array_item(a, a_length-1-tail), json_value_array_item(b, b_length-1-tail)))
+    tail++;
+  size_t a_middle = a_length-head-tail;
+  size_t b_middle = b_length-head-tail;
+  size_t common = a_middle < b_middle ? a_middle : b_middle;
+  
+  /* Change items pairwise, then remove the surplus from the back or add the rest. */
+  size_t length = ds->path_length;
+  bool diffed = true;
+  for (size_t i=head; i<head+common && diffed; i++) {
+    diffed = diff_push_index(ds, i) && diff_value(ds, json_value_array_item(a, i), json_value_array_item(b, i));
+    diff_pop(ds, length);
+  }
+  for (size_t i=head+a_middle; i>head+common && diffed; i--) {
+    diffed = diff_push_index(ds, i-1) && diff_emit(ds, L"remove", VALUE_NONE);
+    diff_pop(ds, length);
+  }
+  for (size_t i=head+common; i<head+b_middle && diffed; i++) {
+    diffed = diff_push_index(ds, i) && diff_emit(ds, L"add", json_value_array_item(b, i));
+    diff_pop(ds, length);
+  }
+  return diffed;
+}
+
+static bool diff_value(diff_state *ds, json_value a, json_value b)
+{
+  /* Frozen subtrees are mostly told apart by identity or memoized hash. */
+  if (a.type == JSON_TYPE_SHARED && b.type == JSON_TYPE_SHARED && json_value_equal(a, b))
+    return true;
+  
+  json_value a_value = json_value_deref(a);
+  json_value b_value = json_value_deref(b);
+  if (a_value.type == JSON_TYPE_OBJECT && b_value.type == JSON_TYPE_OBJECT)
+    return diff_object(ds, a_value.as.object, b_value.as.object);
+  if (JSON_TYPE_IS_ARRAY(a_value.type) && JSON_TYPE_IS_ARRAY(b_value.type))
+    return diff_array(ds, a_value, b_value);
+  
+  /* Scalars, or a change of type. */
+  if (json_value_equal(a_value, b_value))
+    return true;
+  return diff_emit(ds, L"replace", b);
+}
+
+/*
+*** Application.
+*/
+
+/*
+Make a value safe to modify. A frozen value is replaced by a copy whose nested
+containers stay shared, and a packed array is unpacked.
+*/
+static bool patch_own(json_value *value)
+{
+  if (value->type == JSON_TYPE_SHARED) {
+    json_value copy = json_value_clone(json_value_deref(*value));
+    if (copy.type == JSON_TYPE_ERROR)
+      return false;
+    json_value_release(*value);
+    *value = copy;
+  }
+  return json_value_unpack(value);
+}
+
+static json_value *patch_child(json_value *value, const wchar_t *token)
+{
+  if (value->type == JSON_TYPE_OBJECT) {
+    size_t i = object_find(value->as.object, 0, value->as.object.pair_count, token);
+    return i != JSON_KEY_INDEX_NONE ? &value->as.object.pairs[i].value : NULL;
+  }
+  size_t index;
+  if (value->type == JSON_TYPE_ARRAY && pointer_index(token, &index) && index < (size_t)value->as.array[0].as.integer)
+    return &value->as.array[1+index];
+  return NULL;
+}
+
+/*
+Find the value a pointer addresses, without modifying anything.
+*/
+static json_error_type patch_get(json_value document, const wchar_t *pointer, wchar_t *token, json_value *dest)
+{
+  json_value value = document;
+  while (*pointer != L'\0') {
+    if (!pointer_token(&pointer, token))
+      return JSON_ERROR_PATH;
+    value = json_value_deref(value);
+    size_t index;
+    if (value.type == JSON_TYPE_OBJECT) {
+      size_t i = object_find(value.as.object, 0, value.as.object.pair_count, token);
+      if (i == JSON_KEY_INDEX_NONE)
+        return JSON_ERROR_MISSING;
+      value = value.as.object.pairs[i].value;
+    } else if (JSON_TYPE_IS_ARRAY(value.type) && pointer_index(token, &index) && index < json_value_array_length(value)) {
+      value = json_value_array_item(value, index);
+    } else {
+      return JSON_ERROR_MISSING;
+    }
+  }
+  *dest = value;
+  return JSON_ERROR_none_;
+}
+
+/*
+Find the container holding the value a non-empty pointer addresses, making
+every container on the way safe to modify, and leave the last token in token.
+*/
+static json_error_type patch_parent(json_value *document, const wchar_t *pointer, wchar_t *token, json_value **parent)
+{
+  json_value *value = document;
+  while (true) {
+    if (!pointer_token(&pointer, token))
+      return JSON_ERROR_PATH;
+    if (!patch_own(value))
+      return JSON_ERROR_MEMORY;
+    if (value->type != JSON_TYPE_OBJECT && value->type != JSON_TYPE_ARRAY)
+      return JSON_ERROR_MISSING;
+    if (*pointer == L'\0') {
+      *parent = value;
+      return JSON_ERROR_none_;
+    }
+    value = patch_child(value, token);
+    if (value == NULL)
+      return JSON_ERROR_MISSING;
+  }
+}
+
+/*
+Add a value at a pointer, taking ownership of it.
+*/
+static json_error_type patch_add(json_value *document, const wchar_t *pointer, wchar_t *token, json_value value)
+{
+  if (*pointer == L'\0') {
+    json_value_free(*document);
+    *document = value;
+    return JSON_ERROR_none_;
+  }
+  json_value *parent;
+  json_error_type error = patch_parent(document, pointer, token, &parent);
+  if (error != JSON_ERROR_none_) {
+    json_value_free(value);
+    return error;
+  }
+  
+  if (parent->type == JSON_TYPE_OBJECT) {
+    /* Set a member. */
+    json_value *member = patch_child(parent, token);
+    if (member != NULL) {
+      json_value_free(*member);
+      *member = value;
+      return JSON_ERROR_none_;
+    }
+    size_t count = parent->as.object.pair_count;
+    wchar_t *key = wcs_duplicate(token);
+    json_pair *pairs_new = key != NULL ? realloc(parent->as.object.pairs, (count+1)*sizeof(*pairs_new)) : NULL;
+    if (pairs_new == NULL) {
+      free(key);
+      json_value_free(value);
+      return JSON_ERROR_MEMORY;
+    }
+    pairs_new[count] = (json_pair){
+      .key = key,
+      .value = value
+    };
+    parent->as.object.pairs = pairs_new;
+    parent->as.object.pair_count = count+1;
+    return JSON_ERROR_none_;
+  }
+  
+  /* Insert an item, or append it for "-". */
+  size_t count = (size_t)parent->as.array[0].as.integer;
+  size_t index = count;
+  if (wcscmp(token, L"-") != 0 && (!pointer_index(token, &index) || index > count)) {
+    json_value_free(value);
+    return JSON_ERROR_MISSING;
+  }
+  json_value *array_new = realloc(parent->as.array, (count+2)*sizeof(*array_new));
+  if (array_new == NULL) {
+    json_value_free(value);
+    return JSON_ERROR_MEMORY;
+  }
+  memmove(&array_new[2+index], &array_new[1+index], (count-index)*sizeof(*array_new));
+  array_new[1+index] = value;
+  array_new[0].as.integer++;
+  parent->as.array = array_new;
+  return JSON_ERROR_none_;
+}
+
+/*
+Take the value at a pointer out of the document.
+*/
+static json_error_type patch_detach(json_value *document, const wchar_t *pointer, wchar_t *token, json_value *dest)
+{
+  /* The root cannot be removed. */
+  if (*pointer == L'\0')
+    return JSON_ERROR_PATH;
+  json_value *parent;
+  json_error_type error = patch_parent(document, pointer, token, &parent);
+  if (error != JSON_ERROR_none_)
+    return error;
+  
+  if (parent->type == JSON_TYPE_OBJECT) {
+    json_object *object = &parent->as.object;
+    size_t i = object_find(*object, 0, object->pair_count, token);
+    if (i == JSON_KEY_INDEX_NONE)
+      return JSON_ERROR_MISSING;
+    *dest = object->pairs[i].value;
+    free(object->pairs[i].key);
+    memmove(&object->pairs[i], &object->pairs[i+1], (object->pair_count-i-1)*sizeof(*object->pairs));
+    object->pair_count--;
+    return JSON_ERROR_none_;
+  }
+  
+  size_t count = (size_t)parent->as.array[0].as.integer;
+  size_t index;
+  if (!pointer_index(token, &index) || index >= count)
+    return JSON_ERROR_MISSING;
+  *dest = parent->as.array[1+index];
+  memmove(&parent->as.array[1+index], &parent->as.array[2+index], (count-index-1)*sizeof(*parent->as.array));
+  parent->as.array[0].as.integer--;
+  return JSON_ERROR_none_;
+}
+
+/*
+Replace the value at a pointer, taking ownership of the new one.
+*/
+static json_error_type patch_replace(json_value *document, const wchar_t *pointer, wchar_t *token, json_value value)
+{
+  json_value *target = document;
+  if (*pointer != L'\0') {
+    json_value *parent;
+    json_error_type error = patch_parent(document, pointer, token, &parent);
+    target = error == JSON_ERROR_none_ ? patch_child(parent, token) : NULL;
+    if (target == NULL) {
+      json_value_free(value);
+      return error != JSON_ERROR_none_ ? error : JSON_ERROR_MISSING;
+    }
+  }
+  json_value_free(*target);
+  *target = value;
+  return JSON_ERROR_none_;
+}
+
+static json_value *patch_member(json_value operation, const wchar_t *key)
+{
+  size_t i = object_find(operation.as.object, 0, operation.as.object.pair_count, key);
+  return i != JSON_KEY_INDEX_NONE ? &operation.as.object.pairs[i].value : NULL;
+}
+
+/*
+Read a member that must be a string if present.
+*/
+static bool patch_member_string(json_value operation, const wchar_t *key, wchar_t **dest)
+{
+  json_value *member = patch_member(operation, key);
+  *dest = member != NULL && member->type == JSON_TYPE_STRING ? member->as.string : NULL;
+  return member == NULL || *dest != NULL;
+}
+
+static json_error_type patch_operation(json_value *document, json_value operation)
+{
+  operation = json_value_deref(operation);
+  if (operation.type != JSON_TYPE_OBJECT)
+    return JSON_ERROR_PATCH;
+  wchar_t *op;
+  wchar_t *path;
+  wchar_t *from;
+  if (!patch_member_string(operation, L"op", &op) || !patch_member_string(operation, L"path", &path) || !patch_member_string(operation, L"from", &from) || op == NULL || path == NULL)
+    return JSON_ERROR_PATCH;
+  json_value *value = patch_member(operation, L"value");
+  if ((*path != L'\0' && *path != L'/') || (from != NULL && *from != L'\0' && *from != L'/'))
+    return JSON_ERROR_PATH;
+  
+  /* Tokens are never longer than the pointers they come from. */
+  size_t size = wcslen(path);
+  if (from != NULL && wcslen(from) > size)
+    size = wcslen(from);
+  wchar_t *token = malloc((size+1 /* NUL. */)*sizeof(*token));
+  if (token == NULL)
+    return JSON_ERROR_MEMORY;
+  
+  json_error_type error = JSON_ERROR_PATCH;
+  json_value found;
+  if (wcscmp(op, L"add") == 0 || wcscmp(op, L"replace") == 0) {
+    json_value copy = value != NULL ? json_value_clone(*value) : VALUE_ERROR(JSON_ERROR_PATCH);
+    if (copy.type == JSON_TYPE_ERROR)
+      error = value != NULL ? JSON_ERROR_MEMORY : JSON_ERROR_PATCH;
+    else if (op[0] == L'a')
+      error = patch_add(document, path, token, copy);
+    else
+      error = patch_replace(document, path, token, copy);
+  } else if (wcscmp(op, L"remove") == 0) {
+    error = patch_detach(document, path, token, &found);
+    if (error == JSON_ERROR_none_)
+      json_value_free(found);
+  } else if (wcscmp(op, L"move") == 0 && from != NULL) {
+    size_t from_length = wcslen(from);
+    if (wcscmp(from, path) == 0) {
+      error = patch_get(*document, from, token, &found);
+    } else if (wcsncmp(from, path, from_length) == 0 && path[from_length] == L'/') {
+      /* A value cannot move into itself. */
+      error = JSON_ERROR_PATH;
+    } else {
+      error = patch_detach(document, from, token, &found);
+      if (error == JSON_ERROR_none_)
+        error = patch_add(document, path, token, found);
+    }
+  } else if (wcscmp(op, L"copy") == 0 && from != NULL) {
+    error = patch_get(*document, from, token, &found);
+    if (error == JSON_ERROR_none_) {
+      json_value copy = json_value_clone(found);
+      if (copy.type == JSON_TYPE_ERROR)
+        error = JSON_ERROR_MEMORY;
+      else
+        error = patch_add(document, path, token, copy);
+    }
+  } else if (wcscmp(op, L"test") == 0 && value != NULL) {
+    error = patch_get(*document, path, token, &found);
+    if (error == JSON_ERROR_none_ && !json_value_equal(found, *value))
+      error = JSON_ERROR_PATCH;
+  }
+  
+  free(token);
+  return error;
+}
+
+static json_error_type patch_apply(json_value *document, json_value patch)
+{
+  patch = json_value_deref(patch);
+  if (patch.type != JSON_TYPE_ARRAY)
+    return JSON_ERROR_PATCH;
+  for (json_integer i=1; i<=patch.as.array[0].as.integer; i++) {
+    json_error_type error = patch_operation(document, patch.as.array[i]);
+    if (error != JSON_ERROR_none_)
+      return error;
+  }
+  return JSON_ERROR_none_;
+}
+
+static json_error_type merge_apply(json_value *target, json_value patch)
+{
+  /* Anything but an object replaces the target. */
+  json_value patch_value = json_value_deref(patch);
+  if (patch_value.type != JSON_TYPE_OBJECT) {
+    json_value copy = json_value_clone(patch);
+    if (copy.type == JSON_TYPE_ERROR)
+      return JSON_ERROR_MEMORY;
+    json_value_free(*target);
+    *target = copy;
+    return JSON_ERROR_none_;
+  }
+  if (json_value_deref(*target).type != JSON_TYPE_OBJECT) {
+    json_value_free(*target);
+    *target = (json_value){
+      .type = JSON_TYPE_OBJECT,
+      .as.object = (json_object){
+        .pairs = NULL,
+        .pair_count = 0
+      }
+    };
+  } else if (!patch_own(target)) {
+    return JSON_ERROR_MEMORY;
+  }
+
+  /* Make room for every member the patch may add, so pairs stay put while indexed. */
+  json_object *object = &target->as.object;
+  size_t count = object->pair_count;
+  size_t size = count+patch_value.as.object.pair_count;
+  json_pair *pairs_new = realloc(object->pairs, (size > 0 ? size : 1)*sizeof(*pairs_new));
+  if (pairs_new == NULL)
+    return JSON_ERROR_MEMORY;
+  object->pairs = pairs_new;
+  json_key_index index;
+  bool indexed = count > SIZE_LINEAR && json_key_index_create(&index, *object);
+
+  /* Removed members are marked with JSON_TYPE_none_ until the end. */
+  json_error_type error = JSON_ERROR_none_;
+  for (size_t i=0; i<patch_value.as.object.pair_count && error == JSON_ERROR_none_; i++) {
+    json_pair *member = &patch_value.as.object.pairs[i];
+    size_t j = indexed ? json_key_index_find(&index, member->key) : object_find(*object, 0, count, member->key);
+    if (j == JSON_KEY_INDEX_NONE)
+      j = object_find(*object, count, object->pair_count, member->key);
+    bool removal = json_value_deref(member->value).type == JSON_TYPE_NULL;
+    if (j != JSON_KEY_INDEX_NONE) {
+      json_value *value = &object->pairs[j].value;
+      if (removal && value->type != JSON_TYPE_none_) {
+        json_value_free(*value);
+        *value = VALUE_NONE;
+      } else if (!removal) {
+        if (value->type == JSON_TYPE_none_)
+          *value = VALUE_NULL;
+        error = merge_apply(value, member->value);
+      }
+      continue;
+    }
+    if (removal)
+      continue;
+    wchar_t *key = wcs_duplicate(member->key);
+    if (key == NULL) {
+      error = JSON_ERROR_MEMORY;
+      break;
+    }
+    object->pairs[object->pair_count++] = (json_pair){
+      .key = key,
+      .value = VALUE_NULL
+    };
+    error = merge_apply(&object->pairs[object->pair_count-1].value, member->value);
+  }
+  if (indexed)
+    json_key_index_destroy(&index);
+
+  /* Drop removed members. */
+  size_t kept = 0;
+  for (size_t i=0; i<object->pair_count; i++) {
+    if (object->pairs[i].value.type == JSON_TYPE_none_)
+      free(object->pairs[i].key);
+    else
+      object->pairs[kept++] = object->pairs[i];
+  }
+  object->pair_count = kept;
+  return error;
+}
+
+/*
+Apply a patch with one of the functions above to a working copy, and swap the
+document for it only on success. Cloning retains frozen values instead of
+copying them, so a frozen document is patched through a reference of its own.
+*/
+static json_error_type patch_transaction(json_value *document, json_value patch, json_error_type (*apply)(json_value *target, json_value patch))
+{
+  /* Internal errors. */
+  assert(document != NULL);
+
+  json_value target = json_value_clone(*document);
+  if (target.type == JSON_TYPE_ERROR)
+    return JSON_ERROR_MEMORY;
+  json_error_type error = apply(&target, patch);
+  if (error != JSON_ERROR_none_) {
+    json_value_free(target);
+    return error;
+  }
+  json_value_free(*document);
+  *document = target;
+  return JSON_ERROR_none_;
+}
+
+/*
+*** Interface.
+*/
+
+json_value json_diff(json_value a, json_value b)
+{
+  diff_state ds = {
+    .path = malloc(SIZE_PATH*sizeof(*ds.path)),
+    .path_length = 0,
+    .path_size = SIZE_PATH,
+    .error = JSON_ERROR_none_
+  };
+  if (ds.path == NULL)
+    return VALUE_ERROR(JSON_ERROR_MEMORY);
+  if (!json_builder_array(&ds.patch, NULL, 0)) {
+    json_builder_discard(&ds.patch);
+    free(ds.path);
+    return VALUE_ERROR(JSON_ERROR_MEMORY);
+  }
+  ds.path[0] = L'\0';
+
+  diff_value(&ds, a, b);
+  free(ds.path);
+  if (ds.error != JSON_ERROR_none_) {
+    json_builder_discard(&ds.patch);
+    return VALUE_ERROR(ds.error);
+  }
+  return json_builder_finish(&ds.patch);
+}
+
+json_error_type json_patch_apply(json_value *document, json_value patch)
+{
+  return patch_transaction(document, patch, patch_apply);
+}
+
+json_error_type json_merge_patch_apply(json_value *document, json_value patch)
+{
+  return patch_transaction(document, patch, merge_apply);
+}
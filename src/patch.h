@@ -0,0 +1,36 @@
+/*
+patch.h - jsonparse
+Modified 2026-10-19
+*/
+
+#ifndef JSON_PATCH_H
+#define JSON_PATCH_H
+
+/* Header-specific includes. */
+#include "common.h"
+#include "structure.h"
+#include "errors.h"
+
+/*
+*** Interface.
+
+json_diff returns a JSON Patch (RFC 6902), an array of operations that turns a
+into b. Object members are matched by key through a hash index, and arrays are
+compared after trimming their common head and tail, so only the middle where
+they differ is walked item by item. Frozen subtrees that are the same, or whose
+memoized hashes differ, are told apart without walking them; diffing two frozen
+versions of a document therefore costs about as much as the change.
+
+json_patch_apply applies a JSON Patch, and json_merge_patch_apply a JSON Merge
+Patch (RFC 7396), to a document. Values are copied out of the patch. A patch
+applies as a whole or not at all: it works on a copy of the document, which
+replaces the document only if every operation succeeds. Frozen subtrees are
+shared by the copy and copied on write, one level at a time, on the way to a
+change, so a frozen document costs about as much to patch as the change; any
+other document is copied in full. In-situ documents must be cloned before they
+are patched.
+*/
+
+#include "patch_public.h"
+
+#endif /* !JSON_PATCH_H */
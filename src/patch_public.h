@@ -0,0 +1,8 @@
+#ifndef JSON_PATCH_PUBLIC_H
+#define JSON_PATCH_PUBLIC_H
+
+json_value json_diff(json_value a, json_value b);
+json_error_type json_patch_apply(json_value *document, json_value patch);
+json_error_type json_merge_patch_apply(json_value *document, json_value patch);
+
+#endif /* !JSON_PATCH_PUBLIC_H */
@@ -1,6 +1,6 @@
 /*
 public.c - jsonparse
-Modified 2022-10-05
+Modified 2026-10-19
 */
 
 /* Implementation-specific includes. */
@@ -8,7 +8,7 @@ Modified 2022-10-05
 #include "structure.h"
 #include "errors.h"
 #include "parser.h"
-#include <assert.h>
+#include "source.h"
 
 /*
 *** Interface.
@@ -24,22 +24,20 @@ Modified 2022-10-05
 #endif
 #endif
 
-json_value json_parse_stream(FILE *stream)
+/*
+Parse a document and destroy the parser state.
+*/
+static json_value json_parse_document(json_parser_state *ps)
 {
   /* Prepare. */
   json_value value = {
     .type = JSON_TYPE_ERROR,
-    .as.integer = JSON_ERROR_FILE
+    .as.integer = JSON_ERROR_MEMORY
   };
   
   /* Parse. */
-  if (stream == NULL)
-    return value;
-  json_parser_state *ps = json_parser_create(stream);
-  if (ps == NULL) {
-    value.as.integer = JSON_ERROR_MEMORY;
+  if (ps == NULL)
     return value;
-  }
   if (ps->error != JSON_ERROR_none_) {
     value.as.integer = ps->error;
     json_parser_destroy(ps);
@@ -49,18 +47,91 @@ json_value json_parse_stream(FILE *stream)
   if (ps->error != JSON_ERROR_none_) {
     value = (json_value){
       .type = JSON_TYPE_ERROR,
-      .as.integer = ps->error
+      .as.integer = json_parser_error(ps)
     };
     json_parser_destroy(ps);
     return value;
   }
   json_parse_whitespace(ps);
-  assert(ps->wc == WEOF);
+  if (ps->wc != WEOF) {
+    json_parser_discard(ps, value);
+    value = (json_value){
+      .type = JSON_TYPE_ERROR,
+      .as.integer = JSON_ERROR_TRAILING
+    };
+  }
   json_parser_destroy(ps);
   
   return value;
 }
 
+/*
+Parse a document from a source. The source remains the caller's.
+*/
+static json_value json_parse_source(json_source *source, json_parse_flags flags)
+{
+  return json_parse_document(json_parser_create(source, flags));
+}
+
+json_value json_parse_stream_flags(FILE *stream, json_parse_flags flags)
+{
+  /* Prepare. */
+  json_value value = {
+    .type = JSON_TYPE_ERROR,
+    .as.integer = JSON_ERROR_FILE
+  };
+  if (stream == NULL)
+    return value;
+  
+  /* Assemble input. */
+  value.as.integer = JSON_ERROR_MEMORY;
+  json_source *source = json_source_create_file(stream);
+  if (source == NULL)
+    return value;
+  #ifdef JSON_SOURCE_DECOMPRESS
+  json_source *decompress = json_source_create_decompress(source);
+  if (decompress == NULL) {
+    json_source_destroy(source);
+    return value;
+  }
+  source = decompress;
+  #endif
+  #ifdef JSON_ENABLE_READAHEAD
+  if (flags & JSON_PARSE_READAHEAD) {
+    json_source *readahead = json_source_create_readahead(source);
+    if (readahead == NULL) {
+      json_source_destroy(source);
+      return value;
+    }
+    source = readahead;
+  }
+  #endif
+  
+  /* Parse. */
+  value = json_parse_source(source, flags);
+  json_source_destroy(source);
+  return value;
+}
+
+json_value json_parse_stream(FILE *stream)
+{
+  return json_parse_stream_flags(stream, JSON_PARSE_DEFAULT);
+}
+
+json_value json_parse_insitu(wchar_t *text, json_parse_flags flags)
+{
+  /* Prepare. */
+  json_value value = {
+    .type = JSON_TYPE_ERROR,
+    .as.integer = JSON_ERROR_VALUE
+  };
+  if (text == NULL)
+    return value;
+  
+  /* Parse. */
+  return json_parse_document(json_parser_create_insitu(text, flags));
+}
+
 void json_print_error(json_value value)
 {
   if (value.type != JSON_TYPE_ERROR || !JSON_ERROR_TYPE_HAS_MEANING(value.as.integer))
@@ -0,0 +1,889 @@
+/*
+shred.c - jsonparse
+Modified 2026-10-19
+*/
+
+/* Header-specific includes. */
+#include "shred.h"
+
+/* Implementation-specific includes. */
+#include "tools.h"
+#include <assert.h>
+#include <errno.h>
+#include <math.h>
+#include <string.h>
+#include <wchar.h>
+#ifdef JSON_ENABLE_SHRED_THREADS
+#include <pthread.h>
+#endif
+
+/* Constants. */
+#define SIZE_ROWS 1024
+#define SIZE_BYTES 4096
+#define SIZE_STRING 64
+#define SIZE_NUMBER 64
+#define SIZE_STREAM_BLOCK 16777216
+#define SIZE_THREAD_MINIMUM 1048576
+#define COLUMN_NONE SIZE_MAX
+
+/* Helpers. */
+#define BYTE_IS_WHITESPACE(byte) \
+  (byte == ' ' || byte == '\r' || byte == '\t')
+#define BYTE_IS_DIGIT(byte) \
+  (byte >= '0' && byte <= '9')
+
+/*
+*** Paths.
+
+Column paths are compiled into a tree of keys, so a record is walked once no
+matter how many columns it feeds.
+*/
+
+typedef struct shred_node_ {
+  char *key; /* UTF-8. */
+  size_t key_length;
+  size_t column;
+  size_t child_count;
+  struct shred_node_ *children;
+} shred_node;
+
+static void shred_node_free(shred_node *node)
+{
+  for (size_t i=0; i<node->child_count; i++)
+    shred_node_free(&node->children[i]);
+  free(node->children);
+  free(node->key);
+}
+
+static shred_node *shred_node_child(shred_node *node, const char *key, size_t key_length)
+{
+  for (size_t i=0; i<node->child_count; i++)
+    if (node->children[i].key_length == key_length && memcmp(node->children[i].key, key, key_length) == 0)
+      return &node->children[i];
+  return NULL;
+}
+
+/*
+Add the JSON Pointer path of a column to the tree.
+*/
+static json_error_type shred_node_add(shred_node *root, const wchar_t *path, size_t column)
+{
+  if (path == NULL || *path != L'/')
+    return JSON_ERROR_PATH;
+  
+  size_t path_length = wcslen(path);
+  wchar_t *token = malloc((path_length+1)*sizeof(*token));
+  char *key = malloc(path_length*4+1);
+  if (token == NULL || key == NULL) {
+    free(token);
+    free(key);
+    return JSON_ERROR_MEMORY;
+  }
+  shred_node *node = root;
+  json_error_type error = JSON_ERROR_none_;
+  while (*path == L'/') {
+    /* Decode one reference token. */
+    size_t key_length;
+    if (!pointer_token(&path, token) || !wcs_to_utf8(token, key, &key_length)) {
+      error = JSON_ERROR_PATH;
+      break;
+    }
+  
+    /* Find or add the node. */
+    shred_node *child = shred_node_child(node, key, key_length);
+    if (child == NULL) {
+      shred_node *children_new = realloc(node->children, (node->child_count+1)*sizeof(*node->children));
+      if (children_new == NULL) {
+        error = JSON_ERROR_MEMORY;
+        break;
+      }
+      node->children = children_new;
+      child = &node->children[node->child_count];
+      *child = (shred_node){
+        .key = malloc(key_length > 0 ? key_length : 1),
+        .key_length = key_length,
+        .column = COLUMN_NONE,
+        .child_count = 0,
+        .children = NULL
+      };
+      if (child->key == NULL) {
+        error = JSON_ERROR_MEMORY;
+        break;
+      }
+      memcpy(child->key, key, key_length);
+      node->child_count++;
+    }
+    node = child;
+  }
+  free(token);
+  free(key);
+  if (error != JSON_ERROR_none_)
+    return error;
+
+  /* Each path feeds one column. */
+  if (node->column != COLUMN_NONE)
+    return JSON_ERROR_PATH;
+  node->column = column;
+  return JSON_ERROR_none_;
+}
+
+/*
+*** Columns.
+*/
+
+static size_t column_item_size(json_column_type type)
+{
+  switch (type) {
+    case JSON_COLUMN_INTEGER:
+      return sizeof(json_integer);
+    case JSON_COLUMN_FLOATING:
+      return sizeof(json_floating);
+    case JSON_COLUMN_BOOLEAN:
+      return sizeof(bool);
+    case JSON_COLUMN_STRING:
+      return sizeof(size_t);
+  }
+  return 0;
+}
+
+static bool column_reserve(json_column *column, size_t count)
+{
+  /* Strings keep one more offset than rows. */
+  if (count+1 <= column->capacity)
+    return true;
+  size_t capacity = column->capacity > 0 ? column->capacity : SIZE_ROWS;
+  while (count+1 > capacity)
+    capacity *= 2;
+
+  void *values_new = realloc(column->values.integers, capacity*column_item_size(column->type));
+  if (values_new == NULL)
+    return false;
+  column->values.integers = values_new;
+  uint8_t *validity_new = realloc(column->validity, (capacity+7)/8);
+  if (validity_new == NULL)
+    return false;
+  column->validity = validity_new;
+
+  if (column->capacity == 0 && column->type == JSON_COLUMN_STRING)
+    column->values.offsets[0] = 0;
+  column->capacity = capacity;
+  return true;
+}
+
+static bool column_reserve_bytes(json_column *column, size_t length)
+{
+  if (column->byte_count+length <= column->byte_capacity)
+    return true;
+  size_t byte_capacity = column->byte_capacity > 0 ? column->byte_capacity : SIZE_BYTES;
+  while (column->byte_count+length > byte_capacity)
+    byte_capacity *= 2;
+  char *bytes_new = realloc(column->bytes, byte_capacity);
+  if (bytes_new == NULL)
+    return false;
+  column->bytes = bytes_new;
+  column->byte_capacity = byte_capacity;
+  return true;
+}
+
+static void column_set_valid(json_column *column, size_t row, bool valid)
+{
+  if (valid)
+    column->validity[row/8] = (uint8_t)(column->validity[row/8] | 1u << row%8);
+  else
+    column->validity[row/8] = (uint8_t)(column->validity[row/8] & ~(1u << row%8));
+}
+
+/*
+Append a null row. Space must have been reserved.
+*/
+static void column_push_null(json_column *column)
+{
+  size_t row = column->count++;
+  column_set_valid(column, row, false);
+  switch (column->type) {
+    case JSON_COLUMN_INTEGER:
+      column->values.integers[row] = 0;
+      break;
+    case JSON_COLUMN_FLOATING:
+      column->values.floatings[row] = 0;
+      break;
+    case JSON_COLUMN_BOOLEAN:
+      column->values.booleans[row] = false;
+      break;
+    case JSON_COLUMN_STRING:
+      column->values.offsets[row+1] = column->byte_count;
+      break;
+  }
+}
+
+/*
+Drop the rows from count on.
+*/
+static void column_truncate(json_column *column, size_t count)
+{
+  if (column->count <= count)
+    return;
+  column->count = count;
+  if (column->type == JSON_COLUMN_STRING)
+    column->byte_count = column->values.offsets[count];
+}
+
+/*
+Append the rows of another column of the same type.
+*/
+static bool column_append(json_column *column, const json_column *rows)
+{
+  assert(column->type == rows->type);
+  if (rows->count == 0)
+    return true;
+  if (!column_reserve(column, column->count+rows->count))
+    return false;
+
+  size_t item_size = column_item_size(column->type);
+  if (column->type == JSON_COLUMN_STRING) {
+    if (!column_reserve_bytes(column, rows->byte_count))
+      return false;
+    memcpy(column->bytes+column->byte_count, rows->bytes, rows->byte_count);
+    for (size_t i=1; i<=rows->count; i++)
+      column->values.offsets[column->count+i] = column->byte_count+rows->values.offsets[i];
+    column->byte_count += rows->byte_count;
+  } else {
+    memcpy((char*)column->values.integers+column->count*item_size, rows->values.integers, rows->count*item_size);
+  }
+  for (size_t i=0; i<rows->count; i++)
+    column_set_valid(column, column->count+i, json_column_is_valid(rows, i));
+  column->count += rows->count;
+  return true;
+}
+
+/*
+*** Records.
+*/
+
+typedef struct shred_state_ {
+  const char *cursor;
+  const char *end;
+  json_column *columns;
+  size_t column_count;
+  size_t row; /* Rows in each column before the current record. */
+  char *key;
+  size_t key_length;
+  size_t key_capacity;
+  json_error_type error;
+} shred_state;
+
+static bool shred_fail(shred_state *st, json_error_type error)
+{
+  if (st->error == JSON_ERROR_none_)
+    st->error = error;
+  return false;
+}
+
+static void shred_whitespace(shred_state *st)
+{
+  while (st->cursor < st->end && BYTE_IS_WHITESPACE(*st->cursor))
+    st->cursor++;
+}
+
+static bool shred_literal(shred_state *st, const char *literal, json_error_type error)
+{
+  size_t length = strlen(literal);
+  if ((size_t)(st->end-st->cursor) < length || memcmp(st->cursor, literal, length) != 0)
+    return shred_fail(st, error);
+  st->cursor += length;
+  return true;
+}
+
+/*
+Decode a string into UTF-8, appending it to *bytes; with bytes NULL, only
+validate it.
+*/
+static bool shred_string(shred_state *st, char **bytes, size_t *length, size_t *capacity)
+{
+  /* '"' */
+  if (st->cursor == st->end || *st->cursor != '"')
+    return shred_fail(st, JSON_ERROR_STRINGOPEN);
+  st->cursor++;
+
+  while (true) {
+    /* Copy plain runs in one go. */
+    const char *run = st->cursor;
+    while (st->cursor < st->end && (unsigned char)*st->cursor >= 0x20 && (unsigned char)*st->cursor < 0x80 && *st->cursor != '"' && *st->cursor != '\\')
+      st->cursor++;
+    size_t run_length = (size_t)(st->cursor-run);
+    char encoded[4];
+    size_t encoded_length = 0;
+  
+    if (st->cursor == st->end)
+      return shred_fail(st, JSON_ERROR_STRINGCLOSE);
+    if ((unsigned char)*st->cursor < 0x20)
+      return shred_fail(st, JSON_ERROR_STRINGCONTROL);
+    if (*st->cursor == '\\') {
+      /* Escape. */
+      size_t position = 0;
+      uint32_t code_point;
+      if (!text_escape(st->cursor, (size_t)(st->end-st->cursor), &position, &code_point))
+        return shred_fail(st, JSON_ERROR_STRINGESCAPE);
+      st->cursor += position;
+      encoded_length = utf8_encode(code_point, encoded);
+    } else if ((unsigned char)*st->cursor >= 0x80) {
+      /* Multi-byte sequence, kept as it is. */
+      encoded_length = text_utf8(st->cursor, (size_t)(st->end-st->cursor), 0);
+      if (encoded_length == 0)
+        return shred_fail(st, JSON_ERROR_ENCODING);
+      memcpy(encoded, st->cursor, encoded_length);
+      st->cursor += encoded_length;
+    }
+  
+    /* Append. */
+    if (bytes != NULL && run_length+encoded_length > 0) {
+      if (*length+run_length+encoded_length > *capacity) {
+        size_t capacity_new = *capacity > 0 ? *capacity : SIZE_STRING;
+        while (*length+run_length+encoded_length > capacity_new)
+          capacity_new *= 2;
+        char *bytes_new = realloc(*bytes, capacity_new);
+        if (bytes_new == NULL)
+          return shred_fail(st, JSON_ERROR_MEMORY);
+        *bytes = bytes_new;
+        *capacity = capacity_new;
+      }
+      memcpy(*bytes+*length, run, run_length);
+      memcpy(*bytes+*length+run_length, encoded, encoded_length);
+      *length += run_length+encoded_length;
+    }
+  
+    /* '"' */
+    if (encoded_length == 0 && *st->cursor == '"') {
+      st->cursor++;
+      return true;
+    }
+  }
+}
+
+/*
+Validate and skip a number. Sets *integer unless it has a fraction or exponent.
+*/
+static bool shred_number_scan(shred_state *st, bool *integer)
+{
+  *integer = true;
+  if (st->cursor < st->end && *st->cursor == '-')
+    st->cursor++;
+  if (st->cursor == st->end || !BYTE_IS_DIGIT(*st->cursor))
+    return shred_fail(st, JSON_ERROR_VALUE);
+  if (*st->cursor == '0')
+    st->cursor++;
+  else
+    while (st->cursor < st->end && BYTE_IS_DIGIT(*st->cursor))
+      st->cursor++;
+  if (st->cursor < st->end && *st->cursor == '.') {
+    *integer = false;
+    st->cursor++;
+    if (st->cursor == st->end || !BYTE_IS_DIGIT(*st->cursor))
+      return shred_fail(st, JSON_ERROR_FLOATING);
+    while (st->cursor < st->end && BYTE_IS_DIGIT(*st->cursor))
+      st->cursor++;
+  }
+  if (st->cursor < st->end && (*st->cursor == 'e' || *st->cursor == 'E')) {
+    *integer = false;
+    st->cursor++;
+    if (st->cursor < st->end && (*st->cursor == '+' || *st->cursor == '-'))
+      st->cursor++;
+    if (st->cursor == st->end || !BYTE_IS_DIGIT(*st->cursor))
+      return shred_fail(st, JSON_ERROR_FLOATING);
+    while (st->cursor < st->end && BYTE_IS_DIGIT(*st->cursor))
+      st->cursor++;
+  }
+  return true;
+}
+
+/*
+Parse a number for a column of the given type. Integers bound for floating-point
+columns are converted directly. A number the column cannot hold, like one with
+a fraction or outside the range of its type, yields a null value.
+*/
+static bool shred_number(shred_state *st, json_column_type type, json_value *dest)
+{
+  const char *start = st->cursor;
+  bool integer;
+  if (!shred_number_scan(st, &integer))
+    return false;
+
+  /* Convert from a terminated copy. */
+  *dest = (json_value){
+    .type = JSON_TYPE_NULL
+  };
+  if (type == JSON_COLUMN_INTEGER && !integer)
+    return true;
+  size_t length = (size_t)(st->cursor-start);
+  char buffer[SIZE_NUMBER];
+  char *text = length < SIZE_NUMBER ? buffer : malloc(length+1);
+  if (text == NULL)
+    return shred_fail(st, JSON_ERROR_MEMORY);
+  memcpy(text, start, length);
+  text[length] = '\0';
+  errno = 0;
+  if (type == JSON_COLUMN_INTEGER) {
+    long long value = strtoll(text, NULL, 10);
+    if (errno != ERANGE)
+      *dest = (json_value){
+        .type = JSON_TYPE_INTEGER,
+        .as.integer = (json_integer)value
+      };
+  } else {
+    double value = strtod(text, NULL);
+    if (!isinf(value))
+      *dest = (json_value){
+        .type = JSON_TYPE_FLOATING,
+        .as.floating = value
+      };
+  }
+  if (text != buffer)
+    free(text);
+  return true;
+}
+
+/*
+Validate and skip a value.
+*/
+static bool shred_skip(shred_state *st)
+{
+  shred_whitespace(st);
+  if (st->cursor == st->end)
+    return shred_fail(st, JSON_ERROR_VALUE);
+  bool integer;
+  switch (*st->cursor) {
+    case '"':
+      return shred_string(st, NULL, NULL, NULL);
+    case 't':
+      return shred_literal(st, "true", JSON_ERROR_TRUE);
+    case 'f':
+      return shred_literal(st, "false", JSON_ERROR_FALSE);
+    case 'n':
+      return shred_literal(st, "null", JSON_ERROR_NULL);
+    case '[':
+      st->cursor++;
+      shred_whitespace(st);
+      while (st->cursor < st->end && *st->cursor != ']') {
+        if (!shred_skip(st))
+          return false;
+        shred_whitespace(st);
+        if (st->cursor == st->end || *st->cursor != ',')
+          break;
+        st->cursor++;
+      }
+      if (st->cursor == st->end || *st->cursor != ']')
+        return shred_fail(st, JSON_ERROR_ARRAYCLOSE);
+      st->cursor++;
+      return true;
+    case '{':
+      st->cursor++;
+      shred_whitespace(st);
+      while (st->cursor < st->end && *st->cursor != '}') {
+        if (!shred_string(st, NULL, NULL, NULL))
+          return false;
+        shred_whitespace(st);
+        if (st->cursor == st->end || *st->cursor != ':')
+          return shred_fail(st, JSON_ERROR_PAIRSEPERATOR);
+        st->cursor++;
+        if (!shred_skip(st))
+          return false;
+        shred_whitespace(st);
+        if (st->cursor == st->end || *st->cursor != ',')
+          break;
+        st->cursor++;
+        shred_whitespace(st);
+      }
+      if (st->cursor == st->end || *st->cursor != '}')
+        return shred_fail(st, JSON_ERROR_OBJECTCLOSE);
+      st->cursor++;
+      return true;
+    default:
+      return shred_number_scan(st, &integer);
+  }
+}
+
+/*
+Store a scalar in a column, or a null row if its type does not fit.
+*/
+static bool shred_scalar(shred_state *st, json_column *column)
+{
+  json_value number;
+  size_t row = column->count;
+  switch (*st->cursor) {
+    case '"':
+      if (column->type != JSON_COLUMN_STRING)
+        break;
+      if (!shred_string(st, &column->bytes, &column->byte_count, &column->byte_capacity))
+        return false;
+      column->values.offsets[row+1] = column->byte_count;
+      column_set_valid(column, row, true);
+      column->count++;
+      return true;
+    case 't':
+    case 'f':
+      if (column->type != JSON_COLUMN_BOOLEAN)
+        break;
+      column->values.booleans[row] = *st->cursor == 't';
+      if (!shred_literal(st, *st->cursor == 't' ? "true" : "false", *st->cursor == 't' ? JSON_ERROR_TRUE : JSON_ERROR_FALSE))
+        return false;
+      column_set_valid(column, row, true);
+      column->count++;
+      return true;
+    case '-':
+    case '0': case '1': case '2': case '3': case '4':
+    case '5': case '6': case '7': case '8': case '9':
+      if (column->type != JSON_COLUMN_INTEGER && column->type != JSON_COLUMN_FLOATING)
+        break;
+      if (!shred_number(st, column->type, &number))
+        return false;
+      if (number.type == JSON_TYPE_NULL) {
+        column_push_null(column);
+        return true;
+      }
+      if (column->type == JSON_COLUMN_INTEGER)
+        column->values.integers[row] = number.as.integer;
+      else
+        column->values.floatings[row] = number.as.floating;
+      column_set_valid(column, row, true);
+      column->count++;
+      return true;
+    default:
+      break;
+  }
+  column_push_null(column);
+  return shred_skip(st);
+}
+
+static bool shred_object(shred_state *st, shred_node *node);
+
+static bool shred_field(shred_state *st, shred_node *node)
+{
+  shred_whitespace(st);
+  if (st->cursor == st->end)
+    return shred_fail(st, JSON_ERROR_VALUE);
+
+  /* Repeated keys keep their first value. */
+  json_column *column = node->column != COLUMN_NONE ? &st->columns[node->column] : NULL;
+  if (column != NULL && column->count > st->row)
+    column = NULL;
+
+  if (*st->cursor == '{' && node->child_count > 0)
+    return shred_object(st, node);
+  if (column != NULL)
+    return shred_scalar(st, column);
+  return shred_skip(st);
+}
+
+static bool shred_object(shred_state *st, shred_node *node)
+{
+  /* '{' */
+  st->cursor++;
+  shred_whitespace(st);
+
+  /* Pairs. */
+  while (st->cursor < st->end && *st->cursor != '}') {
+    st->key_length = 0;
+    if (!shred_string(st, &st->key, &st->key_length, &st->key_capacity))
+      return false;
+    shred_whitespace(st);
+    if (st->cursor == st->end || *st->cursor != ':')
+      return shred_fail(st, JSON_ERROR_PAIRSEPERATOR);
+    st->cursor++;
+    shred_node *child = shred_node_child(node, st->key, st->key_length);
+    if (!(child != NULL ? shred_field(st, child) : shred_skip(st)))
+      return false;
+    shred_whitespace(st);
+    if (st->cursor == st->end || *st->cursor != ',')
+      break;
+    st->cursor++;
+    shred_whitespace(st);
+  }
+
+  /* '}' */
+  if (st->cursor == st->end || *st->cursor != '}')
+    return shred_fail(st, JSON_ERROR_OBJECTCLOSE);
+  st->cursor++;
+  return true;
+}
+
+/*
+Shred every line of a block of records.
+*/
+static bool shred_block(shred_state *st, shred_node *root, const char *text, size_t length)
+{
+  const char *end = text+length;
+  while (text < end) {
+    /* One record per line. */
+    const char *line_end = memchr(text, '\n', (size_t)(end-text));
+    if (line_end == NULL)
+      line_end = end;
+    st->cursor = text;
+    st->end = line_end;
+    text = line_end < end ? line_end+1 : end;
+    shred_whitespace(st);
+    if (st->cursor == st->end)
+      continue;
+
+    /* Reserve a row in every column. */
+    for (size_t i=0; i<st->column_count; i++)
+      if (!column_reserve(&st->columns[i], st->row+1))
+        return shred_fail(st, JSON_ERROR_MEMORY);
+
+    /* Records that are not objects hold no fields. */
+    if (!(*st->cursor == '{' ? shred_object(st, root) : shred_skip(st)))
+      return false;
+    shred_whitespace(st);
+    if (st->cursor != st->end)
+      return shred_fail(st, JSON_ERROR_TRAILING);
+
+    /* Fields the record lacks are null. */
+    st->row++;
+    for (size_t i=0; i<st->column_count; i++)
+      if (st->columns[i].count < st->row)
+        column_push_null(&st->columns[i]);
+  }
+  return true;
+}
+
+static json_error_type shred_text(shred_node *root, const char *text, size_t length, json_column *columns, size_t column_count)
+{
+  shred_state st = {
+    .columns = columns,
+    .column_count = column_count,
+    .row = column_count > 0 ? columns[0].count : 0,
+    .key = NULL,
+    .key_length = 0,
+    .key_capacity = 0,
+    .error = JSON_ERROR_none_
+  };
+  shred_block(&st, root, text, length);
+  free(st.key);
+  return st.error;
+}
+
+#ifdef JSON_ENABLE_SHRED_THREADS
+
+/*
+*** Threads.
+
+The text is split into chunks of whole lines. Each thread shreds its chunk into
+columns of its own, which are then appended in input order.
+*/
+
+typedef struct shred_task_ {
+  shred_node *root;
+  const char *text;
+  size_t length;
+  json_column *columns;
+  size_t column_count;
+  json_error_type error;
+} shred_task;
+
+static void *shred_task_run(void *argument)
+{
+  shred_task *task = argument;
+  task->error = shred_text(task->root, task->text, task->length, task->columns, task->column_count);
+  return NULL;
+}
+
+static json_error_type shred_text_threads(shred_node *root, const char *text, size_t length, json_column *columns, size_t column_count, size_t thread_count)
+{
+  shred_task *tasks = calloc(thread_count, sizeof(*tasks));
+  pthread_t *threads = calloc(thread_count, sizeof(*threads));
+  bool *started = calloc(thread_count, sizeof(*started));
+  if (tasks == NULL || threads == NULL || started == NULL) {
+    free(tasks);
+    free(threads);
+    free(started);
+    return JSON_ERROR_MEMORY;
+  }
+  
+  /* Start. */
+  json_error_type error = JSON_ERROR_none_;
+  size_t start = 0;
+  for (size_t i=0; i<thread_count; i++) {
+    size_t end = length;
+    if (i+1 < thread_count) {
+      end = length/thread_count*(i+1);
+      if (end < start)
+        end = start;
+      const char *newline = memchr(text+end, '\n', length-end);
+      end = newline != NULL ? (size_t)(newline-text)+1 : length;
+    }
+    tasks[i] = (shred_task){
+      .root = root,
+      .text = text+start,
+      .length = end-start,
+      .columns = calloc(column_count > 0 ? column_count : 1, sizeof(*tasks[i].columns)),
+      .column_count = column_count,
+      .error = JSON_ERROR_none_
+    };
+    if (tasks[i].columns == NULL) {
+      error = JSON_ERROR_MEMORY;
+      break;
+    }
+    for (size_t j=0; j<column_count; j++)
+      json_column_init(&tasks[i].columns[j], columns[j].path, columns[j].type);
+    started[i] = pthread_create(&threads[i], NULL, shred_task_run, &tasks[i]) == 0;
+    if (!started[i]) {
+      error = JSON_ERROR_MEMORY;
+      break;
+    }
+    start = end;
+  }
+  
+  /* Join and append in input order. */
+  for (size_t i=0; i<thread_count; i++) {
+    if (started[i])
+      pthread_join(threads[i], NULL);
+    if (error == JSON_ERROR_none_)
+      error = tasks[i].error;
+    if (tasks[i].columns == NULL)
+      continue;
+    for (size_t j=0; j<column_count; j++) {
+      if (error == JSON_ERROR_none_ && !column_append(&columns[j], &tasks[i].columns[j]))
+        error = JSON_ERROR_MEMORY;
+      json_column_free(&tasks[i].columns[j]);
+    }
+    free(tasks[i].columns);
+  }
+  free(tasks);
+  free(threads);
+  free(started);
+  return error;
+}
+
+#endif
+
+/*
+*** Interface.
+*/
+
+void json_column_init(json_column *column, const wchar_t *path, json_column_type type)
+{
+  assert(column != NULL);
+  *column = (json_column){
+    .path = path,
+    .type = type,
+    .count = 0,
+    .capacity = 0,
+    .validity = NULL,
+    .values.integers = NULL,
+    .bytes = NULL,
+    .byte_count = 0,
+    .byte_capacity = 0
+  };
+}
+
+void json_column_free(json_column *column)
+{
+  assert(column != NULL);
+  free(column->validity);
+  free(column->values.integers);
+  free(column->bytes);
+  json_column_init(column, column->path, column->type);
+}
+
+bool json_column_is_valid(const json_column *column, size_t row)
+{
+  assert(column != NULL);
+  assert(row < column->count);
+  return column->validity[row/8] >> row%8 & 1;
+}
+
+json_error_type json_shred(const char *text, size_t length, json_column *columns, size_t column_count, size_t thread_count)
+{
+  /* Internal errors. */
+  assert(text != NULL || length == 0);
+  assert(columns != NULL || column_count == 0);
+
+  /* Compile paths. Columns must start out with the same number of rows. */
+  shred_node root = {
+    .key = NULL,
+    .key_length = 0,
+    .column = COLUMN_NONE,
+    .child_count = 0,
+    .children = NULL
+  };
+  json_error_type error = JSON_ERROR_none_;
+  for (size_t i=0; i<column_count && error == JSON_ERROR_none_; i++) {
+    assert(columns[i].count == columns[0].count);
+    error = shred_node_add(&root, columns[i].path, i);
+  }
+
+  /* Shred, or leave the columns as they were. */
+  size_t count = column_count > 0 ? columns[0].count : 0;
+  if (error == JSON_ERROR_none_) {
+    #ifdef JSON_ENABLE_SHRED_THREADS
+    if (thread_count > length/SIZE_THREAD_MINIMUM+1)
+      thread_count = length/SIZE_THREAD_MINIMUM+1;
+    if (thread_count > 1)
+      error = shred_text_threads(&root, text, length, columns, column_count, thread_count);
+    else
+      error = shred_text(&root, text, length, columns, column_count);
+    #else
+    error = shred_text(&root, text, length, columns, column_count);
+    #endif
+  }
+  if (error != JSON_ERROR_none_)
+    for (size_t i=0; i<column_count; i++)
+      column_truncate(&columns[i], count);
+  shred_node_free(&root);
+  return error;
+}
+
+json_error_type json_shred_stream(FILE *stream, json_column *columns, size_t column_count, size_t thread_count)
+{
+  /* Internal errors. */
+  assert(columns != NULL || column_count == 0);
+
+  if (stream == NULL)
+    return JSON_ERROR_FILE;
+  size_t buffer_size = SIZE_STREAM_BLOCK;
+  char *buffer = malloc(buffer_size);
+  if (buffer == NULL)
+    return JSON_ERROR_MEMORY;
+
+  /* Shred block by block, carrying partial lines over. */
+  size_t count = column_count > 0 ? columns[0].count : 0;
+  size_t length = 0;
+  json_error_type error = JSON_ERROR_none_;
+  while (error == JSON_ERROR_none_) {
+    if (length == buffer_size) {
+      /* A single line fills the buffer. */
+      char *buffer_new = realloc(buffer, 2*buffer_size);
+      if (buffer_new == NULL) {
+        error = JSON_ERROR_MEMORY;
+        break;
+      }
+      buffer = buffer_new;
+      buffer_size *= 2;
+    }
+    size_t read = fread(buffer+length, 1, buffer_size-length, stream);
+    if (read == 0 && ferror(stream)) {
+      error = JSON_ERROR_FILE;
+      break;
+    }
+    length += read;
+    if (read == 0) {
+      error = json_shred(buffer, length, columns, column_count, thread_count);
+      break;
+    }
+
+    /* Shred complete lines. */
+    size_t complete = length;
+    while (complete > 0 && buffer[complete-1] != '\n')
+      complete--;
+    if (complete == 0)
+      continue;
+    error = json_shred(buffer, complete, columns, column_count, thread_count);
+    memmove(buffer, buffer+complete, length-complete);
+    length -= complete;
+  }
+  free(buffer);
+
+  if (error != JSON_ERROR_none_)
+    for (size_t i=0; i<column_count; i++)
+      column_truncate(&columns[i], count);
+  return error;
+}
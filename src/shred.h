@@ -0,0 +1,34 @@
+/*
+shred.h - jsonparse
+Modified 2026-10-19
+*/
+
+#ifndef JSON_SHRED_H
+#define JSON_SHRED_H
+
+/* Header-specific includes. */
+#include "common.h"
+#include "structure.h"
+#include "errors.h"
+#include <stdio.h>
+
+/*
+*** Interface.
+
+The shredder turns newline-delimited JSON records into columns without building
+a json_value per record. Each column names a field by a JSON Pointer path, such
+as L"/user/id", and appends one row per record: the field's value if it has the
+column's type, otherwise a null row. Integers widen into floating-point columns;
+numbers the column's type cannot hold, like integers beyond 64 bits in an
+integer column, give null rows too. Strings are stored as UTF-8, with row i
+spanning bytes offsets[i] to offsets[i+1]. Bit i%8 of validity[i/8] is set for
+rows that hold a value.
+
+Empty lines are skipped. Malformed records fail the whole call, and the columns
+are left as they were before it. With thread_count > 1, the input is split at
+line boundaries and shredded on several threads.
+*/
+
+#include "shred_public.h"
+
+#endif /* !JSON_SHRED_H */
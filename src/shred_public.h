@@ -0,0 +1,35 @@
+#ifndef JSON_SHRED_PUBLIC_H
+#define JSON_SHRED_PUBLIC_H
+
+typedef enum json_column_type_ {
+  JSON_COLUMN_INTEGER,
+  JSON_COLUMN_FLOATING,
+  JSON_COLUMN_BOOLEAN,
+  JSON_COLUMN_STRING
+} json_column_type;
+
+typedef struct json_column_ {
+  const wchar_t *path;
+  json_column_type type;
+  size_t count;
+  size_t capacity;
+  uint8_t *validity;
+  union json_column_values_ {
+    json_integer *integers;
+    json_floating *floatings;
+    bool *booleans;
+    size_t *offsets;
+  } values;
+  char *bytes;
+  size_t byte_count;
+  size_t byte_capacity;
+} json_column;
+
+void json_column_init(json_column *column, const wchar_t *path, json_column_type type);
+void json_column_free(json_column *column);
+bool json_column_is_valid(const json_column *column, size_t row);
+
+json_error_type json_shred(const char *text, size_t length, json_column *columns, size_t column_count, size_t thread_count);
+json_error_type json_shred_stream(FILE *stream, json_column *columns, size_t column_count, size_t thread_count);
+
+#endif /* !JSON_SHRED_PUBLIC_H */
@@ -0,0 +1,621 @@
+/*
+source.c - jsonparse
+Modified 2026-10-19
+*/
+
+/* Header-specific includes. */
+#include "source.h"
+
+/* Implementation-specific includes. */
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef JSON_ENABLE_READAHEAD
+#include <pthread.h>
+#endif
+#ifdef JSON_ENABLE_GZIP
+#include <zlib.h>
+#endif
+#ifdef JSON_ENABLE_ZSTD
+#include <zstd.h>
+#endif
+
+/* Constants. */
+#define SIZE_READAHEAD_BLOCK 1048576
+#define SIZE_READAHEAD_RING 4
+#define SIZE_DECOMPRESS_INPUT 131072
+
+/*
+*** Files.
+
+Regular files and streams without a descriptor are read through stdio, whose
+reads never wait. Pipes, sockets and terminals are read through the descriptor
+directly, so each call delivers whatever input has arrived instead of waiting
+for a whole block; whatever the caller left in stdio's buffer is not seen.
+They wait for input together with a wake-up pipe, through which reads are
+interrupted. The descriptor's flags are left alone. Either way the stream may
+be read past the end of the document.
+*/
+
+typedef struct source_file_ {
+  json_source base;
+  FILE *stream;
+  int fd;
+  bool waits; /* Reads may wait for input. */
+  int wake[2]; /* Pipe that interrupts waiting reads. */
+} source_file;
+
+static size_t source_file_read(json_source *source, unsigned char *buffer, size_t size)
+{
+  source_file *file = (source_file*)source;
+  if (!file->waits) {
+    size_t length = fread(buffer, 1, size, file->stream);
+    if (length == 0 && ferror(file->stream))
+      source->error = JSON_ERROR_FILE;
+    return length;
+  }
+  
+  while (true) {
+    struct pollfd poll_fds[2] = {
+      { .fd = file->fd, .events = POLLIN },
+      { .fd = file->wake[0], .events = POLLIN }
+    };
+    if (poll(poll_fds, 2, -1) == -1) {
+      if (errno == EINTR)
+        continue;
+      source->error = JSON_ERROR_FILE;
+      return 0;
+    }
+    if (poll_fds[1].revents != 0)
+      return 0;
+    ssize_t length = read(file->fd, buffer, size);
+    if (length >= 0)
+      return (size_t)length;
+    /* The caller's descriptor may be non-blocking. */
+    if (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK)
+      continue;
+    source->error = JSON_ERROR_FILE;
+    return 0;
+  }
+}
+
+static void source_file_interrupt(json_source *source)
+{
+  source_file *file = (source_file*)source;
+  ssize_t written = write(file->wake[1], "", 1);
+  (void)written; /* A full pipe wakes readers as well. */
+}
+
+static void source_file_destroy(json_source *source)
+{
+  /* The stream belongs to the caller. */
+  source_file *file = (source_file*)source;
+  if (file->waits) {
+    close(file->wake[0]);
+    close(file->wake[1]);
+  }
+  free(source);
+}
+
+json_source *json_source_create_file(FILE *stream)
+{
+  /* Internal errors. */
+  assert(stream != NULL);
+  
+  source_file *file = malloc(sizeof(*file));
+  if (file == NULL)
+    return NULL;
+  *file = (source_file){
+    .base = {
+      .read = source_file_read,
+      .interrupt = NULL,
+      .destroy = source_file_destroy,
+      .error = JSON_ERROR_none_
+    },
+    .stream = stream,
+    .fd = fileno(stream),
+    .waits = false,
+    .wake = { -1, -1 }
+  };
+  struct stat status;
+  file->waits = file->fd != -1 && fstat(file->fd, &status) == 0 && !S_ISREG(status.st_mode);
+  if (file->waits) {
+    if (pipe(file->wake) == -1) {
+      free(file);
+      return NULL;
+    }
+    fcntl(file->wake[0], F_SETFD, FD_CLOEXEC);
+    fcntl(file->wake[1], F_SETFD, FD_CLOEXEC);
+    fcntl(file->wake[1], F_SETFL, O_NONBLOCK);
+    file->base.interrupt = source_file_interrupt;
+  }
+  return &file->base;
+}
+
+/*
+*** Memory.
+*/
+
+typedef struct source_memory_ {
+  json_source base;
+  const unsigned char *data;
+  size_t length;
+  size_t offset;
+} source_memory;
+
+static size_t source_memory_read(json_source *source, unsigned char *buffer, size_t size)
+{
+  source_memory *memory = (source_memory*)source;
+  size_t length = memory->length-memory->offset;
+  if (length > size)
+    length = size;
+  if (length == 0)
+    return 0;
+  memcpy(buffer, memory->data+memory->offset, length);
+  memory->offset += length;
+  return length;
+}
+
+static void source_memory_destroy(json_source *source)
+{
+  /* The data belongs to the caller. */
+  free(source);
+}
+
+json_source *json_source_create_memory(const unsigned char *data, size_t length)
+{
+  /* Internal errors. */
+  assert(data != NULL || length == 0);
+  
+  source_memory *memory = malloc(sizeof(*memory));
+  if (memory == NULL)
+    return NULL;
+  *memory = (source_memory){
+    .base = {
+      .read = source_memory_read,
+      .interrupt = NULL,
+      .destroy = source_memory_destroy,
+      .error = JSON_ERROR_none_
+    },
+    .data = data,
+    .length = length,
+    .offset = 0
+  };
+  return &memory->base;
+}
+
+#ifdef JSON_ENABLE_READAHEAD
+
+/*
+*** Readahead.
+
+A reader thread fills a ring of large blocks from the inner source while the
+parser consumes the oldest filled block, so waiting for input overlaps with
+parsing. When parsing stops early, the reader is interrupted rather than left
+waiting for input the document does not need.
+*/
+
+typedef struct source_readahead_ {
+  json_source base;
+  json_source *inner;
+  pthread_t thread;
+  pthread_mutex_t mutex;
+  pthread_cond_t filled;
+  pthread_cond_t drained;
+  unsigned char *blocks[SIZE_READAHEAD_RING];
+  size_t lengths[SIZE_READAHEAD_RING];
+  size_t head; /* Oldest filled block. */
+  size_t count; /* Filled blocks. */
+  size_t offset; /* Bytes of the head block already consumed. */
+  bool finished;
+  bool stopping;
+} source_readahead;
+
+static void *source_readahead_run(void *argument)
+{
+  source_readahead *readahead = argument;
+  
+  pthread_mutex_lock(&readahead->mutex);
+  while (true) {
+    /* Wait for a free block. */
+    while (readahead->count == SIZE_READAHEAD_RING && !readahead->stopping)
+      pthread_cond_wait(&readahead->drained, &readahead->mutex);
+    if (readahead->stopping)
+      break;
+    size_t slot = (readahead->head+readahead->count)%SIZE_READAHEAD_RING;
+    
+    /* Read without holding the lock; the consumer never touches free blocks. */
+    pthread_mutex_unlock(&readahead->mutex);
+    size_t length = readahead->inner->read(readahead->inner, readahead->blocks[slot], SIZE_READAHEAD_BLOCK);
+    pthread_mutex_lock(&readahead->mutex);
+    
+    readahead->lengths[slot] = length;
+    if (length == 0)
+      readahead->finished = true;
+    else
+      readahead->count++;
+    pthread_cond_signal(&readahead->filled);
+    if (readahead->finished)
+      break;
+  }
+  pthread_mutex_unlock(&readahead->mutex);
+  return NULL;
+}
+
+static size_t source_readahead_read(json_source *source, unsigned char *buffer, size_t size)
+{
+  source_readahead *readahead = (source_readahead*)source;
+  
+  /* Wait for a filled block. */
+  pthread_mutex_lock(&readahead->mutex);
+  while (readahead->count == 0 && !readahead->finished)
+    pthread_cond_wait(&readahead->filled, &readahead->mutex);
+  if (readahead->count == 0) {
+    source->error = readahead->inner->error;
+    pthread_mutex_unlock(&readahead->mutex);
+    return 0;
+  }
+  size_t slot = readahead->head;
+  pthread_mutex_unlock(&readahead->mutex);
+  
+  /* Copy without holding the lock; the reader never touches filled blocks. */
+  size_t length = readahead->lengths[slot]-readahead->offset;
+  if (length > size)
+    length = size;
+  memcpy(buffer, readahead->blocks[slot]+readahead->offset, length);
+  readahead->offset += length;
+  
+  /* Hand the block back once it is used up. */
+  if (readahead->offset == readahead->lengths[slot]) {
+    pthread_mutex_lock(&readahead->mutex);
+    readahead->head = (readahead->head+1)%SIZE_READAHEAD_RING;
+    readahead->count--;
+    readahead->offset = 0;
+    pthread_cond_signal(&readahead->drained);
+    pthread_mutex_unlock(&readahead->mutex);
+  }
+  return length;
+}
+
+static void source_readahead_destroy(json_source *source)
+{
+  source_readahead *readahead = (source_readahead*)source;
+  
+  /* Stop and join the reader, waking it if it waits for input. */
+  pthread_mutex_lock(&readahead->mutex);
+  readahead->stopping = true;
+  pthread_cond_signal(&readahead->drained);
+  pthread_mutex_unlock(&readahead->mutex);
+  if (readahead->inner->interrupt != NULL)
+    readahead->inner->interrupt(readahead->inner);
+  pthread_join(readahead->thread, NULL);
+  
+  pthread_cond_destroy(&readahead->drained);
+  pthread_cond_destroy(&readahead->filled);
+  pthread_mutex_destroy(&readahead->mutex);
+  for (size_t i=0; i<SIZE_READAHEAD_RING; i++)
+    free(readahead->blocks[i]);
+  json_source_destroy(readahead->inner);
+  free(readahead);
+}
+
+json_source *json_source_create_readahead(json_source *inner)
+{
+  /* Internal errors. */
+  assert(inner != NULL);
+  
+  source_readahead *readahead = malloc(sizeof(*readahead));
+  if (readahead == NULL)
+    return NULL;
+  *readahead = (source_readahead){
+    .base = {
+      .read = source_readahead_read,
+      .interrupt = NULL,
+      .destroy = source_readahead_destroy,
+      .error = JSON_ERROR_none_
+    },
+    .inner = inner,
+    .head = 0,
+    .count = 0,
+    .offset = 0,
+    .finished = false,
+    .stopping = false
+  };
+  
+  /* Allocate ring. */
+  bool allocated = true;
+  for (size_t i=0; i<SIZE_READAHEAD_RING; i++) {
+    readahead->blocks[i] = malloc(SIZE_READAHEAD_BLOCK);
+    allocated = allocated && readahead->blocks[i] != NULL;
+  }
+  if (!allocated) {
+    for (size_t i=0; i<SIZE_READAHEAD_RING; i++)
+      free(readahead->blocks[i]);
+    free(readahead);
+    return NULL;
+  }
+  
+  /* Start reader. */
+  pthread_mutex_init(&readahead->mutex, NULL);
+  pthread_cond_init(&readahead->filled, NULL);
+  pthread_cond_init(&readahead->drained, NULL);
+  if (pthread_create(&readahead->thread, NULL, source_readahead_run, readahead) != 0) {
+    pthread_cond_destroy(&readahead->drained);
+    pthread_cond_destroy(&readahead->filled);
+    pthread_mutex_destroy(&readahead->mutex);
+    for (size_t i=0; i<SIZE_READAHEAD_RING; i++)
+      free(readahead->blocks[i]);
+    free(readahead);
+    return NULL;
+  }
+  return &readahead->base;
+}
+
+#endif /* JSON_ENABLE_READAHEAD */
+
+#ifdef JSON_SOURCE_DECOMPRESS
+
+/*
+*** Decompression.
+
+The format is recognized by its magic bytes; anything else passes through
+unchanged. Decompressed bytes are written straight into the reader's buffer.
+*/
+
+typedef enum source_format_ {
+  SOURCE_FORMAT_PLAIN,
+  SOURCE_FORMAT_GZIP,
+  SOURCE_FORMAT_ZSTD
+} source_format;
+
+typedef struct source_decompress_ {
+  json_source base;
+  json_source *inner;
+  source_format format;
+  unsigned char *input;
+  size_t input_idx;
+  size_t input_length;
+  bool frame_done;
+  #ifdef JSON_ENABLE_GZIP
+  z_stream gzip;
+  #endif
+  #ifdef JSON_ENABLE_ZSTD
+  ZSTD_DStream *zstd;
+  #endif
+} source_decompress;
+
+/*
+Replace consumed input with the next chunk. Returns false at the end of input.
+*/
+static bool source_decompress_fill(source_decompress *decompress)
+{
+  decompress->input_idx = 0;
+  decompress->input_length = decompress->inner->read(decompress->inner, decompress->input, SIZE_DECOMPRESS_INPUT);
+  return decompress->input_length > 0;
+}
+
+static void source_decompress_fail(source_decompress *decompress)
+{
+  decompress->base.error = decompress->inner->error != JSON_ERROR_none_ ? decompress->inner->error : JSON_ERROR_DECOMPRESS;
+}
+
+#ifdef JSON_ENABLE_GZIP
+static size_t source_decompress_read_gzip(source_decompress *decompress, unsigned char *buffer, size_t size)
+{
+  z_stream *gzip = &decompress->gzip;
+  gzip->next_out = buffer;
+  gzip->avail_out = (uInt)size;
+  while (gzip->avail_out == size) {
+    bool more = decompress->input_idx < decompress->input_length || source_decompress_fill(decompress);
+    /* Concatenated members form one stream. */
+    if (more && decompress->frame_done) {
+      inflateReset(gzip);
+      decompress->frame_done = false;
+    }
+    gzip->next_in = decompress->input+decompress->input_idx;
+    gzip->avail_in = (uInt)(decompress->input_length-decompress->input_idx);
+    int status = inflate(gzip, Z_NO_FLUSH);
+    decompress->input_idx = (size_t)(gzip->next_in-decompress->input);
+    if (status == Z_STREAM_END) {
+      decompress->frame_done = true;
+    } else if (status != Z_OK && status != Z_BUF_ERROR) {
+      source_decompress_fail(decompress);
+      break;
+    }
+    if (!more && gzip->avail_out == size) {
+      if (!decompress->frame_done)
+        source_decompress_fail(decompress);
+      break;
+    }
+  }
+  return size-gzip->avail_out;
+}
+#endif
+
+#ifdef JSON_ENABLE_ZSTD
+static size_t source_decompress_read_zstd(source_decompress *decompress, unsigned char *buffer, size_t size)
+{
+  ZSTD_outBuffer output = {
+    .dst = buffer,
+    .size = size,
+    .pos = 0
+  };
+  while (output.pos == 0) {
+    bool more = decompress->input_idx < decompress->input_length || source_decompress_fill(decompress);
+    ZSTD_inBuffer input = {
+      .src = decompress->input,
+      .size = decompress->input_length,
+      .pos = decompress->input_idx
+    };
+    size_t status = ZSTD_decompressStream(decompress->zstd, &output, &input);
+    decompress->input_idx = input.pos;
+    if (ZSTD_isError(status)) {
+      source_decompress_fail(decompress);
+      break;
+    }
+    /* 0 marks the end of a frame; further frames may follow. */
+    decompress->frame_done = status == 0;
+    if (!more && output.pos == 0) {
+      if (!decompress->frame_done)
+        source_decompress_fail(decompress);
+      break;
+    }
+  }
+  return output.pos;
+}
+#endif
+
+static size_t source_decompress_read(json_source *source, unsigned char *buffer, size_t size)
+{
+  source_decompress *decompress = (source_decompress*)source;
+  if (source->error != JSON_ERROR_none_)
+    return 0;
+  
+  #ifdef JSON_ENABLE_GZIP
+  if (decompress->format == SOURCE_FORMAT_GZIP)
+    return source_decompress_read_gzip(decompress, buffer, size);
+  #endif
+  #ifdef JSON_ENABLE_ZSTD
+  if (decompress->format == SOURCE_FORMAT_ZSTD)
+    return source_decompress_read_zstd(decompress, buffer, size);
+  #endif
+  
+  /* Plain input: hand out the sniffed bytes, then read through. */
+  if (decompress->input_idx < decompress->input_length) {
+    size_t length = decompress->input_length-decompress->input_idx;
+    if (length > size)
+      length = size;
+    memcpy(buffer, decompress->input+decompress->input_idx, length);
+    decompress->input_idx += length;
+    return length;
+  }
+  size_t length = decompress->inner->read(decompress->inner, buffer, size);
+  if (length == 0)
+    source->error = decompress->inner->error;
+  return length;
+}
+
+static void source_decompress_interrupt(json_source *source)
+{
+  source_decompress *decompress = (source_decompress*)source;
+  if (decompress->inner->interrupt != NULL)
+    decompress->inner->interrupt(decompress->inner);
+}
+
+static void source_decompress_destroy(json_source *source)
+{
+  source_decompress *decompress = (source_decompress*)source;
+  #ifdef JSON_ENABLE_GZIP
+  if (decompress->format == SOURCE_FORMAT_GZIP)
+    inflateEnd(&decompress->gzip);
+  #endif
+  #ifdef JSON_ENABLE_ZSTD
+  if (decompress->format == SOURCE_FORMAT_ZSTD)
+    ZSTD_freeDStream(decompress->zstd);
+  #endif
+  free(decompress->input);
+  json_source_destroy(decompress->inner);
+  free(decompress);
+}
+
+/*
+Whether the input read so far is the start of the magic bytes of a format.
+*/
+static bool source_decompress_sniffing(source_decompress *decompress)
+{
+  size_t length = decompress->input_length;
+  #ifdef JSON_ENABLE_GZIP
+  if (length < 2 && memcmp(decompress->input, "\x1f\x8b", length) == 0)
+    return true;
+  #endif
+  #ifdef JSON_ENABLE_ZSTD
+  if (length < 4 && memcmp(decompress->input, "\x28\xb5\x2f\xfd", length) == 0)
+    return true;
+  #endif
+  return false;
+}
+
+json_source *json_source_create_decompress(json_source *inner)
+{
+  /* Internal errors. */
+  assert(inner != NULL);
+  
+  source_decompress *decompress = malloc(sizeof(*decompress));
+  if (decompress == NULL)
+    return NULL;
+  *decompress = (source_decompress){
+    .base = {
+      .read = source_decompress_read,
+      .interrupt = source_decompress_interrupt,
+      .destroy = source_decompress_destroy,
+      .error = JSON_ERROR_none_
+    },
+    .inner = inner,
+    .format = SOURCE_FORMAT_PLAIN,
+    .input = malloc(SIZE_DECOMPRESS_INPUT),
+    .input_idx = 0,
+    .input_length = 0,
+    .frame_done = false
+  };
+  if (decompress->input == NULL) {
+    free(decompress);
+    return NULL;
+  }
+  
+  /* Sniff the magic bytes, reading no further than needed to rule them out. */
+  size_t length;
+  while (source_decompress_sniffing(decompress)) {
+    length = inner->read(inner, decompress->input+decompress->input_length, SIZE_DECOMPRESS_INPUT-decompress->input_length);
+    if (length == 0)
+      break;
+    decompress->input_length += length;
+  }
+  unsigned char *magic = decompress->input;
+  #ifdef JSON_ENABLE_GZIP
+  if (decompress->input_length >= 2 && magic[0] == 0x1f && magic[1] == 0x8b) {
+    decompress->gzip = (z_stream){
+      .zalloc = Z_NULL,
+      .zfree = Z_NULL,
+      .opaque = Z_NULL
+    };
+    if (inflateInit2(&decompress->gzip, 16+MAX_WBITS /* gzip header. */) != Z_OK) {
+      free(decompress->input);
+      free(decompress);
+      return NULL;
+    }
+    decompress->format = SOURCE_FORMAT_GZIP;
+  }
+  #endif
+  #ifdef JSON_ENABLE_ZSTD
+  if (decompress->input_length >= 4 && magic[0] == 0x28 && magic[1] == 0xb5 && magic[2] == 0x2f && magic[3] == 0xfd) {
+    decompress->zstd = ZSTD_createDStream();
+    if (decompress->zstd == NULL) {
+      free(decompress->input);
+      free(decompress);
+      return NULL;
+    }
+    ZSTD_initDStream(decompress->zstd);
+    decompress->format = SOURCE_FORMAT_ZSTD;
+  }
+  #endif
+  (void)magic;
+  return &decompress->base;
+}
+
+#endif /* JSON_SOURCE_DECOMPRESS */
+
+/*
+*** Interface.
+*/
+
+void json_source_destroy(json_source *source)
+{
+  /* Internal errors. */
+  assert(source != NULL);
+  
+  source->destroy(source);
+}
@@ -0,0 +1,51 @@
+/*
+source.h - jsonparse
+Modified 2026-10-19
+*/
+
+#ifndef JSON_SOURCE_H
+#define JSON_SOURCE_H
+
+/* Header-specific includes. */
+#include "common.h"
+#include "errors.h"
+#include <stdio.h>
+
+/* Decompression. */
+#if defined(JSON_ENABLE_GZIP) || defined(JSON_ENABLE_ZSTD)
+#define JSON_SOURCE_DECOMPRESS
+#endif
+
+/*
+Input sources.
+
+A source delivers raw input bytes to the parser. read fills up to size bytes
+and returns how many it delivered; 0 means the input is exhausted, or that
+reading failed, in which case error is set. interrupt, which may be called from
+another thread, makes a read that waits for input, or the next one, return 0
+at once; it is NULL for sources that never wait. Sources can wrap other sources
+and then own them.
+*/
+
+typedef struct json_source_ {
+  size_t (*read)(struct json_source_ *source, unsigned char *buffer, size_t size);
+  void (*interrupt)(struct json_source_ *source);
+  void (*destroy)(struct json_source_ *source);
+  json_error_type error;
+} json_source;
+
+/*
+*** Interface.
+*/
+
+json_source *json_source_create_file(FILE *stream);
+json_source *json_source_create_memory(const unsigned char *data, size_t length);
+#ifdef JSON_ENABLE_READAHEAD
+json_source *json_source_create_readahead(json_source *inner);
+#endif
+#ifdef JSON_SOURCE_DECOMPRESS
+json_source *json_source_create_decompress(json_source *inner);
+#endif
+void json_source_destroy(json_source *source);
+
+#endif /* !JSON_SOURCE_H */
@@ -1,20 +1,30 @@
 /*
 structure.c - jsonparse
-Modified 2022-10-05
+Modified 2026-10-19
 */
 
 /* Header-specific includes. */
 #include "structure.h"
 
 /* Implementation-specific includes. */
+#include "errors.h"
+#include "tools.h"
 #include <assert.h>
+#include <string.h>
 #include <wchar.h>
 
+/* Helpers. */
+#define VALUE_OUT_OF_MEMORY \
+  ((json_value){ .type = JSON_TYPE_ERROR, .as.integer = JSON_ERROR_MEMORY })
+
 /*
-*** Interface.
+*** Helpers.
 */
 
-void json_value_free(json_value value)
+/*
+Free a value, and its strings and keys if they are owned.
+*/
+static void value_free(json_value value, bool strings)
 {
   #ifdef __GNUC__
   #ifdef __clang__
@@ -33,15 +43,16 @@ void json_value_free(json_value value)
     case JSON_TYPE_FLOATING:
       break;
     case JSON_TYPE_STRING:
-      if (value.as.string != NULL)
+      if (strings && value.as.string != NULL)
         free(value.as.string);
       break;
     case JSON_TYPE_OBJECT:
       if (value.as.object.pairs == NULL)
         break;
       for (size_t i=0; i<value.as.object.pair_count; i++) {
-        free(value.as.object.pairs[i].key);
-        json_value_free(value.as.object.pairs[i].value);
+        if (strings)
+          free(value.as.object.pairs[i].key);
+        value_free(value.as.object.pairs[i].value, strings);
       }
       free(value.as.object.pairs);
       break;
@@ -50,9 +61,19 @@ void json_value_free(json_value value)
         break;
       assert(value.as.array[0].type == JSON_TYPE_SIZE);
       for (json_integer i=0; i<1+value.as.array[0].as.integer; i++)
-        json_value_free(value.as.array[i]);
+        value_free(value.as.array[i], strings);
       free(value.as.array);
       break;
+    case JSON_TYPE_SHARED:
+      json_value_release(value);
+      break;
+    case JSON_TYPE_NUMBER:
+      free(value.as.number);
+      break;
+    case JSON_TYPE_INTEGER_ARRAY:
+    case JSON_TYPE_FLOATING_ARRAY:
+      free(value.as.packed.items);
+      break;
     default:
       assert(false);
   }
@@ -65,6 +86,20 @@ void json_value_free(json_value value)
   #endif
 }
 
+/*
+*** Interface.
+*/
+
+void json_value_free(json_value value)
+{
+  value_free(value, true);
+}
+
+void json_value_free_insitu(json_value value)
+{
+  value_free(value, false);
+}
+
 void json_value_represent(json_value value)
 {
   assert(JSON_TYPE_HAS_MEANING(value.type));
@@ -120,6 +155,23 @@ void json_value_represent(json_value value)
       }
       wprintf(L"}");
       break;
+    case JSON_TYPE_SHARED:
+      json_value_represent(value.as.shared->value);
+      break;
+    case JSON_TYPE_NUMBER:
+      wprintf(JSON_WPRI_STRING, value.as.number->text);
+      break;
+    case JSON_TYPE_INTEGER_ARRAY:
+    case JSON_TYPE_FLOATING_ARRAY:
+      wprintf(L"[");
+      assert(JSON_PACKED_IS_INTEGROUS(value));
+      for (size_t i=0; i<value.as.packed.count; i++) {
+        if (i > 0)
+          wprintf(L",");
+        json_value_represent(json_value_array_item(value, i));
+      }
+      wprintf(L"]");
+      break;
   }
   #ifdef __GNUC__
   #ifdef __clang__
@@ -136,3 +188,335 @@ void json_pair_represent(json_pair pair)
   wprintf(L"\"" JSON_WPRI_STRING L"\":", pair.key);
   json_value_represent(pair.value);
 }
+
+json_value json_value_freeze(json_value value)
+{
+  /* Errors and frozen values are passed through. */
+  if (value.type == JSON_TYPE_ERROR || value.type == JSON_TYPE_SHARED)
+    return value;
+  assert(JSON_TYPE_HAS_MEANING(value.type));
+  
+  /* Freeze nested containers first, so each can be shared on its own. */
+  json_value *child;
+  if (value.type == JSON_TYPE_ARRAY) {
+    assert(JSON_ARRAY_IS_INTEGROUS(value));
+    for (json_integer i=1; i<=value.as.array[0].as.integer; i++) {
+      child = &value.as.array[i];
+      if (!JSON_TYPE_IS_ARRAY(child->type) && child->type != JSON_TYPE_OBJECT)
+        continue;
+      *child = json_value_freeze(*child);
+      if (child->type == JSON_TYPE_ERROR) {
+        child->type = JSON_TYPE_NULL;
+        json_value_free(value);
+        return VALUE_OUT_OF_MEMORY;
+      }
+    }
+  } else if (value.type == JSON_TYPE_OBJECT) {
+    assert(JSON_OBJECT_IS_INTEGROUS(value));
+    for (size_t i=0; i<value.as.object.pair_count; i++) {
+      child = &value.as.object.pairs[i].value;
+      if (!JSON_TYPE_IS_ARRAY(child->type) && child->type != JSON_TYPE_OBJECT)
+        continue;
+      *child = json_value_freeze(*child);
+      if (child->type == JSON_TYPE_ERROR) {
+        child->type = JSON_TYPE_NULL;
+        json_value_free(value);
+        return VALUE_OUT_OF_MEMORY;
+      }
+    }
+  }
+  
+  /* Box value. */
+  json_shared *shared = malloc(sizeof(*shared));
+  if (shared == NULL) {
+    json_value_free(value);
+    return VALUE_OUT_OF_MEMORY;
+  }
+  atomic_init(&shared->references, 1);
+  atomic_init(&shared->hash, 0);
+  shared->value = value;
+  return (json_value){
+    .type = JSON_TYPE_SHARED,
+    .as.shared = shared
+  };
+}
+
+json_value json_value_retain(json_value value)
+{
+  assert(value.type == JSON_TYPE_SHARED);
+  assert(value.as.shared != NULL);
+  atomic_fetch_add_explicit(&value.as.shared->references, 1, memory_order_relaxed);
+  return value;
+}
+
+void json_value_release(json_value value)
+{
+  assert(value.type == JSON_TYPE_SHARED);
+  assert(value.as.shared != NULL);
+  
+  /* Only the last owner tears the value down. */
+  if (atomic_fetch_sub_explicit(&value.as.shared->references, 1, memory_order_acq_rel) != 1)
+    return;
+  json_value_free(value.as.shared->value);
+  free(value.as.shared);
+}
+
+json_value json_value_deref(json_value value)
+{
+  if (value.type != JSON_TYPE_SHARED)
+    return value;
+  assert(value.as.shared != NULL);
+  return value.as.shared->value;
+}
+
+json_value json_value_clone(json_value value)
+{
+  assert(JSON_TYPE_HAS_MEANING(value.type));
+  #ifdef __GNUC__
+  #ifdef __clang__
+  #pragma clang diagnostic push
+  #pragma clang diagnostic ignored "-Wswitch-enum"
+  #else
+  #pragma GCC diagnostic push
+  #pragma GCC diagnostic ignored "-Wswitch-enum"
+  #endif
+  #endif
+  json_value clone = value;
+  switch (value.type) {
+    case JSON_TYPE_SHARED:
+      return json_value_retain(value);
+    case JSON_TYPE_STRING:
+      clone.as.string = wcs_duplicate(value.as.string);
+      if (clone.as.string == NULL)
+        return VALUE_OUT_OF_MEMORY;
+      break;
+    case JSON_TYPE_NUMBER:
+      clone.as.number = json_number_create(value.as.number->hint, value.as.number->text, wcslen(value.as.number->text));
+      if (clone.as.number == NULL)
+        return VALUE_OUT_OF_MEMORY;
+      break;
+    case JSON_TYPE_INTEGER_ARRAY:
+    case JSON_TYPE_FLOATING_ARRAY: {
+      assert(JSON_PACKED_IS_INTEGROUS(value));
+      size_t size = value.as.packed.count*(value.type == JSON_TYPE_INTEGER_ARRAY ? sizeof(json_integer) : sizeof(json_floating));
+      clone.as.packed.items = malloc(size);
+      if (clone.as.packed.items == NULL)
+        return VALUE_OUT_OF_MEMORY;
+      memcpy(clone.as.packed.items, value.as.packed.items, size);
+      break;
+    }
+    case JSON_TYPE_ARRAY: {
+      assert(JSON_ARRAY_IS_INTEGROUS(value));
+      json_integer count = value.as.array[0].as.integer;
+      clone.as.array = malloc((size_t)(1+count)*sizeof(*clone.as.array));
+      if (clone.as.array == NULL)
+        return VALUE_OUT_OF_MEMORY;
+      clone.as.array[0] = value.as.array[0];
+      for (json_integer i=1; i<=count; i++) {
+        clone.as.array[i] = json_value_clone(value.as.array[i]);
+        if (clone.as.array[i].type == JSON_TYPE_ERROR) {
+          clone.as.array[0].as.integer = i-1;
+          json_value_free(clone);
+          return VALUE_OUT_OF_MEMORY;
+        }
+      }
+      break;
+    }
+    case JSON_TYPE_OBJECT: {
+      assert(JSON_OBJECT_IS_INTEGROUS(value));
+      size_t count = value.as.object.pair_count;
+      clone.as.object.pairs = malloc((count > 0 ? count : 1)*sizeof(*clone.as.object.pairs));
+      if (clone.as.object.pairs == NULL)
+        return VALUE_OUT_OF_MEMORY;
+      for (size_t i=0; i<count; i++) {
+        clone.as.object.pair_count = i;
+        wchar_t *key = wcs_duplicate(value.as.object.pairs[i].key);
+        if (key == NULL) {
+          json_value_free(clone);
+          return VALUE_OUT_OF_MEMORY;
+        }
+        json_value item = json_value_clone(value.as.object.pairs[i].value);
+        if (item.type == JSON_TYPE_ERROR) {
+          free(key);
+          json_value_free(clone);
+          return VALUE_OUT_OF_MEMORY;
+        }
+        clone.as.object.pairs[i] = (json_pair){
+          .key = key,
+          .value = item
+        };
+      }
+      clone.as.object.pair_count = count;
+      break;
+    }
+    default:
+      break;
+  }
+  #ifdef __GNUC__
+  #ifdef __clang__
+  #pragma clang diagnostic pop
+  #else
+  #pragma GCC diagnostic pop
+  #endif
+  #endif
+  return clone;
+}
+
+json_number *json_number_create(json_type hint, const wchar_t *text, size_t length)
+{
+  /* Internal errors. */
+  assert(hint == JSON_TYPE_INTEGER || hint == JSON_TYPE_FLOATING);
+  assert(text != NULL);
+  
+  json_number *number = malloc(sizeof(*number)+(length+1 /* NUL. */)*sizeof(*number->text));
+  if (number == NULL)
+    return NULL;
+  number->hint = hint;
+  atomic_init(&number->converted, 0);
+  atomic_init(&number->integer, 0);
+  atomic_init(&number->floating, 0);
+  wmemcpy(number->text, text, length);
+  number->text[length] = L'\0';
+  return number;
+}
+
+bool json_value_integer(json_value value, json_integer *dest)
+{
+  assert(dest != NULL);
+  value = json_value_deref(value);
+  if (value.type == JSON_TYPE_INTEGER) {
+    *dest = value.as.integer;
+    return true;
+  }
+  if (value.type != JSON_TYPE_NUMBER || value.as.number->hint != JSON_TYPE_INTEGER)
+    return false;
+  
+  /* Convert on first access. */
+  json_number *number = value.as.number;
+  unsigned converted = atomic_load_explicit(&number->converted, memory_order_acquire);
+  if (!(converted & JSON_NUMBER_INTEGER)) {
+    json_integer integer;
+    converted = JSON_NUMBER_INTEGER;
+    if (wcs_to_json_integer(number->text, &integer)) {
+      atomic_store_explicit(&number->integer, integer, memory_order_relaxed);
+      converted |= JSON_NUMBER_INTEGER_VALID;
+    }
+    converted |= atomic_fetch_or_explicit(&number->converted, converted, memory_order_release);
+  }
+  if (!(converted & JSON_NUMBER_INTEGER_VALID))
+    return false;
+  *dest = (json_integer)atomic_load_explicit(&number->integer, memory_order_relaxed);
+  return true;
+}
+
+bool json_value_floating(json_value value, json_floating *dest)
+{
+  assert(dest != NULL);
+  value = json_value_deref(value);
+  if (value.type == JSON_TYPE_FLOATING) {
+    *dest = value.as.floating;
+    return true;
+  }
+  if (value.type == JSON_TYPE_INTEGER) {
+    *dest = (json_floating)value.as.integer;
+    return true;
+  }
+  if (value.type != JSON_TYPE_NUMBER)
+    return false;
+  
+  /* Convert on first access. */
+  json_number *number = value.as.number;
+  unsigned converted = atomic_load_explicit(&number->converted, memory_order_acquire);
+  if (!(converted & JSON_NUMBER_FLOATING)) {
+    json_floating floating;
+    converted = JSON_NUMBER_FLOATING;
+    if (wcs_to_json_floating(number->text, &floating)) {
+      uint64_t bits;
+      memcpy(&bits, &floating, sizeof(bits));
+      atomic_store_explicit(&number->floating, bits, memory_order_relaxed);
+      converted |= JSON_NUMBER_FLOATING_VALID;
+    }
+    converted |= atomic_fetch_or_explicit(&number->converted, converted, memory_order_release);
+  }
+  if (!(converted & JSON_NUMBER_FLOATING_VALID))
+    return false;
+  uint64_t bits = atomic_load_explicit(&number->floating, memory_order_relaxed);
+  memcpy(dest, &bits, sizeof(*dest));
+  return true;
+}
+
+const wchar_t *json_value_number_text(json_value value)
+{
+  value = json_value_deref(value);
+  if (value.type != JSON_TYPE_NUMBER)
+    return NULL;
+  return value.as.number->text;
+}
+
+const json_integer *json_value_integers(json_value value, size_t *count)
+{
+  assert(count != NULL);
+  value = json_value_deref(value);
+  if (value.type != JSON_TYPE_INTEGER_ARRAY)
+    return NULL;
+  *count = value.as.packed.count;
+  return value.as.packed.items;
+}
+
+const json_floating *json_value_floatings(json_value value, size_t *count)
+{
+  assert(count != NULL);
+  value = json_value_deref(value);
+  if (value.type != JSON_TYPE_FLOATING_ARRAY)
+    return NULL;
+  *count = value.as.packed.count;
+  return value.as.packed.items;
+}
+
+bool json_value_unpack(json_value *value)
+{
+  if (!JSON_TYPE_IS_PACKED(value->type))
+    return true;
+  size_t count = value->as.packed.count;
+  json_value *array = malloc((1+count)*sizeof(*array));
+  if (array == NULL)
+    return false;
+  array[0] = (json_value){
+    .type = JSON_TYPE_SIZE,
+    .as.integer = (json_integer)count
+  };
+  for (size_t i=0; i<count; i++)
+    array[1+i] = json_value_array_item(*value, i);
+  free(value->as.packed.items);
+  *value = (json_value){
+    .type = JSON_TYPE_ARRAY,
+    .as.array = array
+  };
+  return true;
+}
+
+size_t json_value_array_length(json_value value)
+{
+  value = json_value_deref(value);
+  if (JSON_TYPE_IS_PACKED(value.type))
+    return value.as.packed.count;
+  assert(JSON_ARRAY_IS_INTEGROUS(value));
+  return (size_t)value.as.array[0].as.integer;
+}
+
+json_value json_value_array_item(json_value value, size_t index)
+{
+  value = json_value_deref(value);
+  assert(index < json_value_array_length(value));
+  if (value.type == JSON_TYPE_INTEGER_ARRAY)
+    return (json_value){
+      .type = JSON_TYPE_INTEGER,
+      .as.integer = ((json_integer *)value.as.packed.items)[index]
+    };
+  if (value.type == JSON_TYPE_FLOATING_ARRAY)
+    return (json_value){
+      .type = JSON_TYPE_FLOATING,
+      .as.floating = ((json_floating *)value.as.packed.items)[index]
+    };
+  return value.as.array[1+index];
+}
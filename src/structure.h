@@ -1,6 +1,6 @@
 /*
 structure.h - jsonparse
-Modified 2022-09-17
+Modified 2026-10-19
 */
 
 #ifndef JSON_STRUCTURE_H
@@ -10,6 +10,7 @@ Modified 2022-09-17
 #include "common.h"
 #include <stddef.h>
 #include <stdint.h>
+#include <stdatomic.h>
 
 /*
 Helpers.
@@ -21,6 +22,15 @@ Helpers.
 #define JSON_ARRAY_IS_INTEGROUS(value) \
   (value.type == JSON_TYPE_ARRAY && value.as.array != NULL && value.as.array[0].type == JSON_TYPE_SIZE && value.as.array[0].as.integer >= 0)
 
+#define JSON_TYPE_IS_PACKED(type) \
+  (type == JSON_TYPE_INTEGER_ARRAY || type == JSON_TYPE_FLOATING_ARRAY)
+
+#define JSON_TYPE_IS_ARRAY(type) \
+  (type == JSON_TYPE_ARRAY || JSON_TYPE_IS_PACKED(type))
+
+#define JSON_PACKED_IS_INTEGROUS(value) \
+  (JSON_TYPE_IS_PACKED(value.type) && value.as.packed.items != NULL && value.as.packed.count > 0)
+
 #define JSON_OBJECT_IS_INTEGROUS(value) \
   (value.type == JSON_TYPE_OBJECT && value.as.object.pairs != NULL)
 
@@ -35,4 +45,43 @@ JSON data types and interface.
 
 void json_pair_represent(json_pair pair);
 
+/*
+Unconverted numbers. Conversions are cached once done; the flags say which
+were done and which succeeded. Frozen numbers may be converted by several
+threads at once, so the cache is atomic.
+*/
+
+#define JSON_NUMBER_INTEGER 1u
+#define JSON_NUMBER_INTEGER_VALID 2u
+#define JSON_NUMBER_FLOATING 4u
+#define JSON_NUMBER_FLOATING_VALID 8u
+
+typedef struct json_number_ {
+  json_type hint; /* JSON_TYPE_INTEGER or JSON_TYPE_FLOATING. */
+  atomic_uint converted; /* JSON_NUMBER_* flags. */
+  atomic_int_least64_t integer;
+  atomic_uint_least64_t floating; /* Bits of the json_floating. */
+  wchar_t text[];
+} json_number;
+
+json_number *json_number_create(json_type hint, const wchar_t *text, size_t length);
+
+/*
+Packed arrays. json_value_unpack turns a packed array into a regular one in
+place; anything else is left alone. It fails only if memory runs out, and the
+value is then unchanged.
+*/
+
+bool json_value_unpack(json_value *value);
+
+/*
+Frozen values.
+*/
+
+typedef struct json_shared_ {
+  atomic_size_t references;
+  atomic_uint_least64_t hash; /* 0 until memoized by json_value_hash. */
+  json_value value;
+} json_shared;
+
 #endif /* JSON_STRUCTURE_H */
@@ -1,3 +1,6 @@
+#ifndef JSON_STRUCTURE_PUBLIC_H
+#define JSON_STRUCTURE_PUBLIC_H
+
 #include <inttypes.h>
 
 #define JSON_WPRI_INTEGER L"%" PRId64
@@ -15,6 +18,10 @@ typedef enum json_type_ {
   JSON_TYPE_STRING,
   JSON_TYPE_ARRAY,
   JSON_TYPE_OBJECT,
+  JSON_TYPE_SHARED,
+  JSON_TYPE_NUMBER,
+  JSON_TYPE_INTEGER_ARRAY,
+  JSON_TYPE_FLOATING_ARRAY,
   JSON_TYPE_max_
 } json_type;
 
@@ -26,6 +33,11 @@ typedef struct json_object_ {
   struct json_pair_ *pairs;
 } json_object;
 
+typedef struct json_packed_ {
+  size_t count;
+  void *items;
+} json_packed;
+
 typedef struct json_value_ {
   json_type type;
   union json_value_as_ {
@@ -33,7 +45,10 @@ typedef struct json_value_ {
     json_floating floating;
     wchar_t *string;
     json_object object;
+    json_packed packed;
     struct json_value_ *array;
+    struct json_shared_ *shared;
+    struct json_number_ *number;
   } as;
 } json_value;
 
@@ -44,3 +59,52 @@ typedef struct json_pair_ {
 
 void json_value_free(json_value value);
 void json_value_represent(json_value value);
+
+/*
+In-situ documents. json_parse_insitu parses a NUL-terminated text and unescapes
+strings and keys in place, so they point into the text instead of being copied.
+The text must outlive the document, which is released with
+json_value_free_insitu; json_value_clone yields an independent copy. In-situ
+values must not be frozen.
+*/
+void json_value_free_insitu(json_value value);
+
+/*
+Frozen documents. json_value_freeze takes ownership of a value and returns an
+immutable, reference-counted handle (JSON_TYPE_SHARED) in which every nested
+array and object is itself shared. Handles are retained and released in O(1)
+and may be passed between threads; json_value_deref yields the underlying value,
+which must not be modified. json_value_clone deep-copies a value, but retains
+shared subtrees instead of copying them.
+*/
+json_value json_value_freeze(json_value value);
+json_value json_value_retain(json_value value);
+void json_value_release(json_value value);
+json_value json_value_deref(json_value value);
+json_value json_value_clone(json_value value);
+
+/*
+Number access. Numbers parsed with JSON_PARSE_LAZY_NUMBERS keep their source
+text (JSON_TYPE_NUMBER) and are converted when first read through these
+functions, which cache the result and accept eagerly parsed numbers as well.
+json_value_integer fails if the number is not an integer that fits
+json_integer.
+*/
+bool json_value_integer(json_value value, json_integer *dest);
+bool json_value_floating(json_value value, json_floating *dest);
+const wchar_t *json_value_number_text(json_value value);
+
+/*
+Packed arrays. Arrays parsed with JSON_PARSE_PACKED_ARRAYS that hold only
+integers or only floating-point numbers are stored as contiguous json_integer
+(JSON_TYPE_INTEGER_ARRAY) or json_floating (JSON_TYPE_FLOATING_ARRAY) items.
+json_value_integers and json_value_floatings return the items of such arrays,
+or NULL for any other value. json_value_array_length and json_value_array_item
+access packed and regular arrays alike; items of regular arrays are borrowed.
+*/
+const json_integer *json_value_integers(json_value value, size_t *count);
+const json_floating *json_value_floatings(json_value value, size_t *count);
+size_t json_value_array_length(json_value value);
+json_value json_value_array_item(json_value value, size_t index);
+
+#endif /* !JSON_STRUCTURE_PUBLIC_H */
@@ -1,14 +1,22 @@
 /*
 tools.c - jsonparse
-Modified 2022-09-16
+Modified 2026-10-19
 */
 
 /* Header-specific includes. */
 #include "tools.h"
 
 /* Implementaton-specific includes. */
+#include <errno.h>
+#include <math.h>
 #include <wchar.h>
 
+/* Helpers. */
+#define BYTE_IS_WHITESPACE(byte) \
+  (byte == ' ' || byte == '\n' || byte == '\r' || byte == '\t')
+#define BYTE_IS_DELIMITER(byte) \
+  (BYTE_IS_WHITESPACE(byte) || byte == ',' || byte == ':' || byte == ']' || byte == '}')
+
 /*
 Convert a wchar_t string into a json_integer integer.
 Extracted from thechnet/une 0.9.1 codebase, adapted.
@@ -17,12 +25,14 @@ bool wcs_to_json_integer(wchar_t *wcs, json_integer *dest)
 {
   wchar_t *wcs_end = wcs+wcslen(wcs);
   wchar_t *int_end;
+  errno = 0;
   *dest = wcstoll(wcs, &int_end, 10);
-  return int_end == wcs_end ? true : false;
+  return int_end == wcs_end && errno != ERANGE ? true : false;
 }
 
 /*
-Convert a wchar_t string into a une_flt floating pointer number.
+Convert a wchar_t string into a une_flt floating pointer number. Numbers too
+large for json_floating fail, since JSON cannot represent infinities.
 Extracted from thechnet/une 0.9.1 codebase, adapted.
 */
 bool wcs_to_json_floating(wchar_t *wcs, json_floating *dest)
@@ -30,5 +40,299 @@ bool wcs_to_json_floating(wchar_t *wcs, json_floating *dest)
   wchar_t *wcs_end = wcs+wcslen(wcs);
   wchar_t *flt_end;
   *dest = wcstod(wcs, &flt_end);
-  return flt_end == wcs_end ? true : false;
+  return flt_end == wcs_end && !isinf(*dest) ? true : false;
+}
+
+/*
+Duplicate a wchar_t string. Returns NULL if out of memory.
+*/
+wchar_t *wcs_duplicate(wchar_t *wcs)
+{
+  size_t size = wcslen(wcs)+1 /* NUL. */;
+  wchar_t *duplicate = malloc(size*sizeof(*duplicate));
+  if (duplicate == NULL)
+    return NULL;
+  wmemcpy(duplicate, wcs, size);
+  return duplicate;
+}
+
+/*
+Encode a Unicode code point as UTF-8. dest must have room for 4 bytes. Returns
+the number of bytes written, or 0 if code_point is not a Unicode scalar value.
+*/
+size_t utf8_encode(uint32_t code_point, char *dest)
+{
+  if (code_point < 0x80) {
+    dest[0] = (char)code_point;
+    return 1;
+  }
+  if (code_point < 0x800) {
+    dest[0] = (char)(0xc0 | code_point >> 6);
+    dest[1] = (char)(0x80 | (code_point & 0x3f));
+    return 2;
+  }
+  if (code_point >= 0xd800 && code_point <= 0xdfff)
+    return 0;
+  if (code_point < 0x10000) {
+    dest[0] = (char)(0xe0 | code_point >> 12);
+    dest[1] = (char)(0x80 | (code_point >> 6 & 0x3f));
+    dest[2] = (char)(0x80 | (code_point & 0x3f));
+    return 3;
+  }
+  if (code_point < 0x110000) {
+    dest[0] = (char)(0xf0 | code_point >> 18);
+    dest[1] = (char)(0x80 | (code_point >> 12 & 0x3f));
+    dest[2] = (char)(0x80 | (code_point >> 6 & 0x3f));
+    dest[3] = (char)(0x80 | (code_point & 0x3f));
+    return 4;
+  }
+  return 0;
+}
+
+/*
+Encode a NUL-terminated string as UTF-8 into dest, which must have room for 4
+bytes per character, and store the number of bytes in *length. Fails if the
+string holds something other than Unicode scalar values.
+*/
+bool wcs_to_utf8(const wchar_t *wcs, char *dest, size_t *length)
+{
+  *length = 0;
+  for (; *wcs != L'\0'; wcs++) {
+    size_t encoded_length = utf8_encode((uint32_t)*wcs, dest+*length);
+    if (encoded_length == 0)
+      return false;
+    *length += encoded_length;
+  }
+  return true;
+}
+
+/*
+Return the value of a hexadecimal digit, or -1 if character is none.
+*/
+int hex_digit(uint32_t character)
+{
+  if (character >= '0' && character <= '9')
+    return (int)(character-'0');
+  if (character >= 'a' && character <= 'f')
+    return (int)(character-'a'+10);
+  if (character >= 'A' && character <= 'F')
+    return (int)(character-'A'+10);
+  return -1;
+}
+
+/*
+Return the character that a single-letter escape such as '\\n' stands for, or
+0 if letter does not form one. '\\u' escapes are not single-letter.
+*/
+uint32_t escape_character(uint32_t letter)
+{
+  switch (letter) {
+    case '"':
+    case '\\':
+    case '/':
+      return letter;
+    case 'b':
+      return '\b';
+    case 'f':
+      return '\f';
+    case 'n':
+      return '\n';
+    case 'r':
+      return '\r';
+    case 't':
+      return '\t';
+    default:
+      return 0;
+  }
+}
+
+/*
+*** Text scanning.
+*/
+
+void text_skip_whitespace(const char *text, size_t end, size_t *position)
+{
+  while (*position < end && BYTE_IS_WHITESPACE(text[*position]))
+    (*position)++;
+}
+
+/*
+Skip the string starting at position without decoding it.
+*/
+void text_skip_string(const char *text, size_t end, size_t *position)
+{
+  /* '"' */
+  (*position)++;
+  while (*position < end && text[*position] != '"') {
+    if (text[*position] == '\\' && *position+1 < end)
+      (*position)++;
+    (*position)++;
+  }
+  /* '"' */
+  if (*position < end)
+    (*position)++;
+}
+
+/*
+Read the four hexadecimal digits of a '\\uXXXX' escape at position.
+*/
+bool text_hex4(const char *text, size_t end, size_t *position, uint32_t *dest)
+{
+  if (end-*position < 4)
+    return false;
+  uint32_t value = 0;
+  for (int i=0; i<4; i++) {
+    int digit = hex_digit((unsigned char)text[*position+(size_t)i]);
+    if (digit < 0)
+      return false;
+    value = value << 4 | (uint32_t)digit;
+  }
+  *position += 4;
+  *dest = value;
+  return true;
+}
+
+/*
+Decode the escape sequence starting with the '\\' at position, joining
+surrogate pairs. Like the parser, this rejects '\\u0000' and lone surrogates.
+*/
+bool text_escape(const char *text, size_t end, size_t *position, uint32_t *code_point)
+{
+  /* '\\' */
+  (*position)++;
+  if (*position >= end)
+    return false;
+  char letter = text[(*position)++];
+  if (letter != 'u') {
+    *code_point = escape_character((unsigned char)letter);
+    return *code_point != 0;
+  }
+  if (!text_hex4(text, end, position, code_point) || *code_point == 0 || (*code_point >= 0xdc00 && *code_point <= 0xdfff))
+    return false;
+  if (*code_point >= 0xd800 && *code_point <= 0xdbff) {
+    /* Surrogate pair. */
+    uint32_t low;
+    if (end-*position < 2 || text[*position] != '\\' || text[*position+1] != 'u')
+      return false;
+    *position += 2;
+    if (!text_hex4(text, end, position, &low) || low < 0xdc00 || low > 0xdfff)
+      return false;
+    *code_point = 0x10000+((*code_point-0xd800) << 10)+(low-0xdc00);
+  }
+  return true;
+}
+
+/*
+Validate the multi-byte UTF-8 sequence at position and return its length, or 0
+if it is malformed, overlong or encodes a surrogate.
+*/
+size_t text_utf8(const char *text, size_t end, size_t position)
+{
+  const unsigned char *bytes = (const unsigned char*)text+position;
+  size_t length;
+  uint32_t code_point;
+  uint32_t minimum;
+  if (bytes[0] >= 0xc2 && bytes[0] <= 0xdf) {
+    length = 2;
+    code_point = bytes[0] & 0x1f;
+    minimum = 0x80;
+  } else if (bytes[0] >= 0xe0 && bytes[0] <= 0xef) {
+    length = 3;
+    code_point = bytes[0] & 0x0f;
+    minimum = 0x800;
+  } else if (bytes[0] >= 0xf0 && bytes[0] <= 0xf4) {
+    length = 4;
+    code_point = bytes[0] & 0x07;
+    minimum = 0x10000;
+  } else {
+    return 0;
+  }
+  if (end-position < length)
+    return 0;
+  for (size_t i=1; i<length; i++) {
+    if ((bytes[i] & 0xc0) != 0x80)
+      return 0;
+    code_point = code_point << 6 | (bytes[i] & 0x3f);
+  }
+  if (code_point < minimum || (code_point >= 0xd800 && code_point <= 0xdfff) || code_point > 0x10ffff)
+    return 0;
+  return length;
+}
+
+/*
+Skip the value at position without validating it. Containers are skipped by
+counting brackets outside of strings.
+*/
+void text_skip_value(const char *text, size_t end, size_t *position)
+{
+  if (*position >= end)
+    return;
+  if (text[*position] == '"') {
+    text_skip_string(text, end, position);
+  } else if (text[*position] == '{' || text[*position] == '[') {
+    size_t nesting = 0;
+    while (*position < end) {
+      char byte = text[*position];
+      if (byte == '"') {
+        text_skip_string(text, end, position);
+        continue;
+      }
+      (*position)++;
+      if (byte == '{' || byte == '[')
+        nesting++;
+      else if ((byte == '}' || byte == ']') && --nesting == 0)
+        break;
+    }
+  } else {
+    while (*position < end && !BYTE_IS_DELIMITER(text[*position]))
+      (*position)++;
+  }
+}
+
+/*
+*** JSON Pointers.
+*/
+
+/*
+Decode the next reference token of a JSON Pointer, which starts at the '/'.
+token must have room for the rest of the pointer.
+*/
+bool pointer_token(const wchar_t **pointer, wchar_t *token)
+{
+  const wchar_t *cursor = *pointer;
+  size_t length = 0;
+  for (cursor++; *cursor != L'\0' && *cursor != L'/'; cursor++) {
+    wchar_t wc = *cursor;
+    if (wc == L'~') {
+      cursor++;
+      if (*cursor != L'0' && *cursor != L'1')
+        return false;
+      wc = *cursor == L'0' ? L'~' : L'/';
+    }
+    token[length++] = wc;
+  }
+  token[length] = L'\0';
+  *pointer = cursor;
+  return true;
+}
+
+/*
+Read an array index token. Leading zeros, signs and anything too large for
+size_t are no index.
+*/
+bool pointer_index(const wchar_t *token, size_t *index)
+{
+  if (*token == L'\0' || (token[0] == L'0' && token[1] != L'\0'))
+    return false;
+  size_t value = 0;
+  for (; *token != L'\0'; token++) {
+    if (*token < L'0' || *token > L'9')
+      return false;
+    size_t digit = (size_t)(*token-L'0');
+    if (value > (SIZE_MAX-digit)/10)
+      return false;
+    value = value*10+digit;
+  }
+  *index = value;
+  return true;
 }
@@ -1,6 +1,6 @@
 /*
 common.h - jsonparse
-Modified 2022-09-16
+Modified 2026-10-19
 */
 
 #ifndef JSON_TOOLS_H
@@ -16,5 +16,31 @@ Modified 2022-09-16
 
 bool wcs_to_json_integer(wchar_t *wcs, json_integer *dest);
 bool wcs_to_json_floating(wchar_t *wcs, json_floating *dest);
+wchar_t *wcs_duplicate(wchar_t *wcs);
+size_t utf8_encode(uint32_t code_point, char *dest);
+bool wcs_to_utf8(const wchar_t *wcs, char *dest, size_t *length);
+int hex_digit(uint32_t character);
+uint32_t escape_character(uint32_t letter);
+
+/*
+*** Text scanning.
+
+These step over JSON text held in memory as UTF-8. position is an offset into
+text and stays at or below end.
+*/
+
+void text_skip_whitespace(const char *text, size_t end, size_t *position);
+void text_skip_string(const char *text, size_t end, size_t *position);
+bool text_hex4(const char *text, size_t end, size_t *position, uint32_t *dest);
+bool text_escape(const char *text, size_t end, size_t *position, uint32_t *code_point);
+size_t text_utf8(const char *text, size_t end, size_t position);
+void text_skip_value(const char *text, size_t end, size_t *position);
+
+/*
+*** JSON Pointers.
+*/
+
+bool pointer_token(const wchar_t **pointer, wchar_t *token);
+bool pointer_index(const wchar_t *token, size_t *index);
 
 #endif /* !JSON_TOOLS_H */
@@ -0,0 +1,493 @@
+/*
+writer.c - jsonparse
+Modified 2026-10-19
+*/
+
+/* Header-specific includes. */
+#include "writer.h"
+
+/* Implementation-specific includes. */
+#include "tools.h"
+#include <assert.h>
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Constants. */
+#define SIZE_MEMORY 4096
+#define SIZE_BUFFER 65536
+#define SIZE_FRAMES 16
+#define SIZE_ESCAPE 12 /* Two '\uXXXX' escapes. */
+
+/*
+*** Helpers.
+*/
+
+static json_writer *writer_create(json_writer_sink sink, size_t buffer_size)
+{
+  json_writer *writer = malloc(sizeof(*writer));
+  if (writer == NULL)
+    return NULL;
+  *writer = (json_writer){
+    .sink = sink,
+    .fd = -1,
+    .callback = NULL,
+    .context = NULL,
+    .buffer = malloc(buffer_size),
+    .buffer_size = buffer_size,
+    .buffer_idx = 0,
+    .frames = malloc(SIZE_FRAMES*sizeof(*writer->frames)),
+    .frame_size = SIZE_FRAMES,
+    .frame_idx = 0,
+    .complete = false,
+    .error = JSON_ERROR_none_
+  };
+  if (writer->buffer == NULL || writer->frames == NULL) {
+    json_writer_destroy(writer);
+    return NULL;
+  }
+  return writer;
+}
+
+static bool writer_fail(json_writer *writer, json_error_type error)
+{
+  if (writer->error == JSON_ERROR_none_)
+    writer->error = error;
+  return false;
+}
+
+static bool writer_drain(json_writer *writer)
+{
+  assert(writer->sink != JSON_WRITER_SINK_MEMORY);
+  
+  if (writer->sink == JSON_WRITER_SINK_CALLBACK) {
+    if (writer->buffer_idx > 0 && !writer->callback(writer->context, writer->buffer, writer->buffer_idx))
+      return writer_fail(writer, JSON_ERROR_WRITE);
+    writer->buffer_idx = 0;
+    return true;
+  }
+  
+  size_t written = 0;
+  while (written < writer->buffer_idx) {
+    ssize_t result = write(writer->fd, writer->buffer+written, writer->buffer_idx-written);
+    if (result < 0 && errno == EINTR)
+      continue;
+    if (result <= 0)
+      return writer_fail(writer, JSON_ERROR_WRITE);
+    written += (size_t)result;
+  }
+  writer->buffer_idx = 0;
+  return true;
+}
+
+/*
+Ensure size contiguous bytes are available at the buffer cursor.
+*/
+static bool writer_reserve(json_writer *writer, size_t size)
+{
+  if (writer->buffer_size-writer->buffer_idx >= size)
+    return true;
+  
+  if (writer->sink != JSON_WRITER_SINK_MEMORY) {
+    assert(size <= writer->buffer_size);
+    return writer_drain(writer);
+  }
+  
+  size_t buffer_size = writer->buffer_size;
+  while (buffer_size-writer->buffer_idx < size)
+    buffer_size *= 2;
+  char *buffer_new = realloc(writer->buffer, buffer_size);
+  if (buffer_new == NULL)
+    return writer_fail(writer, JSON_ERROR_MEMORY);
+  writer->buffer = buffer_new;
+  writer->buffer_size = buffer_size;
+  return true;
+}
+
+static bool writer_put(json_writer *writer, const char *bytes, size_t length)
+{
+  while (length > 0) {
+    size_t chunk = length;
+    if (writer->sink != JSON_WRITER_SINK_MEMORY && chunk > writer->buffer_size)
+      chunk = writer->buffer_size;
+    if (!writer_reserve(writer, chunk))
+      return false;
+    memcpy(writer->buffer+writer->buffer_idx, bytes, chunk);
+    writer->buffer_idx += chunk;
+    bytes += chunk;
+    length -= chunk;
+  }
+  return true;
+}
+
+static bool writer_put_string(json_writer *writer, const wchar_t *string)
+{
+  if (!writer_put(writer, "\"", 1))
+    return false;
+  for (; *string != L'\0'; string++) {
+    if (!writer_reserve(writer, SIZE_ESCAPE))
+      return false;
+    char *out = writer->buffer+writer->buffer_idx;
+    uint32_t code_point = (uint32_t)*string;
+    /* Plain ASCII. */
+    if (code_point >= 0x20 && code_point < 0x80 && code_point != '"' && code_point != '\\') {
+      *out = (char)code_point;
+      writer->buffer_idx++;
+      continue;
+    }
+    /* Short escapes. */
+    char escape = '\0';
+    switch (code_point) {
+      case '"': escape = '"'; break;
+      case '\\': escape = '\\'; break;
+      case '\b': escape = 'b'; break;
+      case '\f': escape = 'f'; break;
+      case '\n': escape = 'n'; break;
+      case '\r': escape = 'r'; break;
+      case '\t': escape = 't'; break;
+      default: break;
+    }
+    if (escape != '\0') {
+      out[0] = '\\';
+      out[1] = escape;
+      writer->buffer_idx += 2;
+      continue;
+    }
+    /* Join surrogate pairs (UTF-16 wchar_t). */
+    if (code_point >= 0xd800 && code_point <= 0xdbff && (uint32_t)string[1] >= 0xdc00 && (uint32_t)string[1] <= 0xdfff) {
+      code_point = 0x10000+((code_point-0xd800) << 10)+((uint32_t)string[1]-0xdc00);
+      string++;
+    }
+    /* Other control characters and lone surrogates are escaped, the rest is encoded. */
+    size_t length = code_point < 0x20 ? 0 : utf8_encode(code_point, out);
+    if (length == 0 && code_point > 0xffff)
+      length = utf8_encode(0xfffd, out);
+    if (length == 0)
+      length = (size_t)snprintf(out, SIZE_ESCAPE, "\\u%04x", (unsigned)code_point);
+    writer->buffer_idx += length;
+  }
+  return writer_put(writer, "\"", 1);
+}
+
+/*
+Check that a value may be written now, and emit its separator.
+*/
+static bool writer_begin_value(json_writer *writer)
+{
+  if (writer->error != JSON_ERROR_none_)
+    return false;
+  if (writer->frame_idx == 0)
+    return writer->complete ? writer_fail(writer, JSON_ERROR_WRITERSTATE) : true;
+  json_writer_frame *frame = &writer->frames[writer->frame_idx-1];
+  if (frame->object) {
+    if (!frame->has_key)
+      return writer_fail(writer, JSON_ERROR_WRITERSTATE);
+    frame->has_key = false;
+    return true;
+  }
+  return frame->count++ == 0 ? true : writer_put(writer, ",", 1);
+}
+
+static void writer_end_value(json_writer *writer)
+{
+  if (writer->frame_idx == 0)
+    writer->complete = true;
+}
+
+static bool writer_open(json_writer *writer, bool object)
+{
+  if (!writer_begin_value(writer))
+    return false;
+  if (writer->frame_idx >= writer->frame_size) {
+    size_t frame_size = 2*writer->frame_size;
+    json_writer_frame *frames_new = realloc(writer->frames, frame_size*sizeof(*frames_new));
+    if (frames_new == NULL)
+      return writer_fail(writer, JSON_ERROR_MEMORY);
+    writer->frames = frames_new;
+    writer->frame_size = frame_size;
+  }
+  writer->frames[writer->frame_idx++] = (json_writer_frame){
+    .object = object,
+    .has_key = false,
+    .count = 0
+  };
+  return writer_put(writer, object ? "{" : "[", 1);
+}
+
+static bool writer_close(json_writer *writer, bool object)
+{
+  if (writer->error != JSON_ERROR_none_)
+    return false;
+  if (writer->frame_idx == 0)
+    return writer_fail(writer, JSON_ERROR_WRITERSTATE);
+  json_writer_frame *frame = &writer->frames[writer->frame_idx-1];
+  if (frame->object != object || frame->has_key)
+    return writer_fail(writer, JSON_ERROR_WRITERSTATE);
+  writer->frame_idx--;
+  if (!writer_put(writer, object ? "}" : "]", 1))
+    return false;
+  writer_end_value(writer);
+  return true;
+}
+
+static bool writer_scalar(json_writer *writer, const char *text, size_t length)
+{
+  if (!writer_begin_value(writer) || !writer_put(writer, text, length))
+    return false;
+  writer_end_value(writer);
+  return true;
+}
+
+/*
+Write the source text of a lazily parsed number. It is plain ASCII.
+*/
+static bool writer_number(json_writer *writer, const wchar_t *text)
+{
+  if (!writer_begin_value(writer))
+    return false;
+  for (; *text != L'\0'; text++) {
+    if (!writer_reserve(writer, 1))
+      return false;
+    writer->buffer[writer->buffer_idx++] = (char)*text;
+  }
+  writer_end_value(writer);
+  return true;
+}
+
+/*
+*** Interface.
+*/
+
+json_writer *json_writer_create_memory(void)
+{
+  return writer_create(JSON_WRITER_SINK_MEMORY, SIZE_MEMORY);
+}
+
+json_writer *json_writer_create_fd(int fd)
+{
+  json_writer *writer = writer_create(JSON_WRITER_SINK_FD, SIZE_BUFFER);
+  if (writer != NULL)
+    writer->fd = fd;
+  return writer;
+}
+
+json_writer *json_writer_create_callback(json_writer_callback callback, void *context)
+{
+  assert(callback != NULL);
+  json_writer *writer = writer_create(JSON_WRITER_SINK_CALLBACK, SIZE_BUFFER);
+  if (writer != NULL) {
+    writer->callback = callback;
+    writer->context = context;
+  }
+  return writer;
+}
+
+void json_writer_destroy(json_writer *writer)
+{
+  /* Internal errors. */
+  assert(writer != NULL);
+  
+  /* Unflushed output is discarded. */
+  free(writer->buffer);
+  free(writer->frames);
+  free(writer);
+}
+
+bool json_writer_begin_object(json_writer *writer)
+{
+  assert(writer != NULL);
+  return writer_open(writer, true);
+}
+
+bool json_writer_end_object(json_writer *writer)
+{
+  assert(writer != NULL);
+  return writer_close(writer, true);
+}
+
+bool json_writer_begin_array(json_writer *writer)
+{
+  assert(writer != NULL);
+  return writer_open(writer, false);
+}
+
+bool json_writer_end_array(json_writer *writer)
+{
+  assert(writer != NULL);
+  return writer_close(writer, false);
+}
+
+bool json_writer_key(json_writer *writer, const wchar_t *key)
+{
+  assert(writer != NULL);
+  assert(key != NULL);
+  
+  if (writer->error != JSON_ERROR_none_)
+    return false;
+  if (writer->frame_idx == 0)
+    return writer_fail(writer, JSON_ERROR_WRITERSTATE);
+  json_writer_frame *frame = &writer->frames[writer->frame_idx-1];
+  if (!frame->object || frame->has_key)
+    return writer_fail(writer, JSON_ERROR_WRITERSTATE);
+  if (frame->count++ > 0 && !writer_put(writer, ",", 1))
+    return false;
+  frame->has_key = true;
+  return writer_put_string(writer, key) && writer_put(writer, ":", 1);
+}
+
+bool json_writer_null(json_writer *writer)
+{
+  assert(writer != NULL);
+  return writer_scalar(writer, "null", 4);
+}
+
+bool json_writer_boolean(json_writer *writer, bool boolean)
+{
+  assert(writer != NULL);
+  return boolean ? writer_scalar(writer, "true", 4) : writer_scalar(writer, "false", 5);
+}
+
+bool json_writer_integer(json_writer *writer, json_integer integer)
+{
+  assert(writer != NULL);
+  char text[24];
+  int length = snprintf(text, sizeof(text), "%" PRId64, integer);
+  return writer_scalar(writer, text, (size_t)length);
+}
+
+bool json_writer_floating(json_writer *writer, json_floating floating)
+{
+  assert(writer != NULL);
+  
+  /* JSON has no representation for infinities and NaN. */
+  if (!isfinite(floating))
+    return writer_fail(writer, JSON_ERROR_NONFINITE);
+  
+  /* Shortest precision that survives a round trip; 17 digits always do. */
+  char text[40];
+  int length = 0;
+  for (int precision=15; precision<=17; precision++) {
+    length = snprintf(text, sizeof(text), "%.*g", precision, floating);
+    if (strtod(text, NULL) == floating)
+      break;
+  }
+  
+  /* Keep the number floating-point when read back. */
+  if (strpbrk(text, ".e") == NULL) {
+    memcpy(text+length, ".0", 3);
+    length += 2;
+  }
+  return writer_scalar(writer, text, (size_t)length);
+}
+
+bool json_writer_string(json_writer *writer, const wchar_t *string)
+{
+  assert(writer != NULL);
+  assert(string != NULL);
+  if (!writer_begin_value(writer) || !writer_put_string(writer, string))
+    return false;
+  writer_end_value(writer);
+  return true;
+}
+
+bool json_writer_value(json_writer *writer, json_value value)
+{
+  assert(writer != NULL);
+  #ifdef __GNUC__
+  #ifdef __clang__
+  #pragma clang diagnostic push
+  #pragma clang diagnostic ignored "-Wswitch-enum"
+  #else
+  #pragma GCC diagnostic push
+  #pragma GCC diagnostic ignored "-Wswitch-enum"
+  #endif
+  #endif
+  switch (value.type) {
+    case JSON_TYPE_NULL:
+      return json_writer_null(writer);
+    case JSON_TYPE_BOOLEAN:
+      return json_writer_boolean(writer, value.as.integer != 0);
+    case JSON_TYPE_INTEGER:
+      return json_writer_integer(writer, value.as.integer);
+    case JSON_TYPE_FLOATING:
+      return json_writer_floating(writer, value.as.floating);
+    case JSON_TYPE_STRING:
+      return json_writer_string(writer, value.as.string);
+    case JSON_TYPE_ARRAY:
+      assert(JSON_ARRAY_IS_INTEGROUS(value));
+      if (!json_writer_begin_array(writer))
+        return false;
+      for (json_integer i=1; i<=value.as.array[0].as.integer; i++)
+        if (!json_writer_value(writer, value.as.array[i]))
+          return false;
+      return json_writer_end_array(writer);
+    case JSON_TYPE_OBJECT:
+      assert(JSON_OBJECT_IS_INTEGROUS(value));
+      if (!json_writer_begin_object(writer))
+        return false;
+      for (size_t i=0; i<value.as.object.pair_count; i++)
+        if (!json_writer_key(writer, value.as.object.pairs[i].key) || !json_writer_value(writer, value.as.object.pairs[i].value))
+          return false;
+      return json_writer_end_object(writer);
+    case JSON_TYPE_SHARED:
+      return json_writer_value(writer, json_value_deref(value));
+    case JSON_TYPE_NUMBER:
+      return writer_number(writer, value.as.number->text);
+    case JSON_TYPE_INTEGER_ARRAY: {
+      assert(JSON_PACKED_IS_INTEGROUS(value));
+      const json_integer *integers = value.as.packed.items;
+      if (!json_writer_begin_array(writer))
+        return false;
+      for (size_t i=0; i<value.as.packed.count; i++)
+        if (!json_writer_integer(writer, integers[i]))
+          return false;
+      return json_writer_end_array(writer);
+    }
+    case JSON_TYPE_FLOATING_ARRAY: {
+      assert(JSON_PACKED_IS_INTEGROUS(value));
+      const json_floating *floatings = value.as.packed.items;
+      if (!json_writer_begin_array(writer))
+        return false;
+      for (size_t i=0; i<value.as.packed.count; i++)
+        if (!json_writer_floating(writer, floatings[i]))
+          return false;
+      return json_writer_end_array(writer);
+    }
+    default:
+      return writer_fail(writer, JSON_ERROR_VALUE);
+  }
+  #ifdef __GNUC__
+  #ifdef __clang__
+  #pragma clang diagnostic pop
+  #else
+  #pragma GCC diagnostic pop
+  #endif
+  #endif
+}
+
+bool json_writer_flush(json_writer *writer)
+{
+  assert(writer != NULL);
+  if (writer->error != JSON_ERROR_none_)
+    return false;
+  if (writer->sink == JSON_WRITER_SINK_MEMORY)
+    return true;
+  return writer_drain(writer);
+}
+
+const char *json_writer_buffer(json_writer *writer, size_t *length)
+{
+  assert(writer != NULL);
+  assert(writer->sink == JSON_WRITER_SINK_MEMORY);
+  if (length != NULL)
+    *length = writer->buffer_idx;
+  return writer->buffer;
+}
+
+json_error_type json_writer_error(json_writer *writer)
+{
+  assert(writer != NULL);
+  return writer->error;
+}
@@ -0,0 +1,57 @@
+/*
+writer.h - jsonparse
+Modified 2026-10-19
+*/
+
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+/* Header-specific includes. */
+#include "common.h"
+#include "structure.h"
+#include "errors.h"
+
+/*
+*** Interface.
+
+The writer emits compact UTF-8 JSON straight into its sink. Memory sinks keep
+the whole document; fd and callback sinks go through a fixed buffer, so output
+size does not affect memory use. Calls that do not fit the current nesting fail
+with JSON_ERROR_WRITERSTATE. Errors are sticky: once a call fails, all further
+calls fail as well.
+*/
+
+#include "writer_public.h"
+
+/*
+Writer state.
+*/
+
+typedef enum json_writer_sink_ {
+  JSON_WRITER_SINK_MEMORY,
+  JSON_WRITER_SINK_FD,
+  JSON_WRITER_SINK_CALLBACK
+} json_writer_sink;
+
+typedef struct json_writer_frame_ {
+  bool object;
+  bool has_key;
+  size_t count;
+} json_writer_frame;
+
+struct json_writer_ {
+  json_writer_sink sink;
+  int fd;
+  json_writer_callback callback;
+  void *context;
+  char *buffer;
+  size_t buffer_size;
+  size_t buffer_idx;
+  json_writer_frame *frames;
+  size_t frame_size;
+  size_t frame_idx;
+  bool complete;
+  json_error_type error;
+};
+
+#endif /* !JSON_WRITER_H */
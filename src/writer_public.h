@@ -0,0 +1,28 @@
+#ifndef JSON_WRITER_PUBLIC_H
+#define JSON_WRITER_PUBLIC_H
+
+typedef struct json_writer_ json_writer;
+typedef bool (*json_writer_callback)(void *context, const char *bytes, size_t length);
+
+json_writer *json_writer_create_memory(void);
+json_writer *json_writer_create_fd(int fd);
+json_writer *json_writer_create_callback(json_writer_callback callback, void *context);
+void json_writer_destroy(json_writer *writer);
+
+bool json_writer_begin_object(json_writer *writer);
+bool json_writer_end_object(json_writer *writer);
+bool json_writer_begin_array(json_writer *writer);
+bool json_writer_end_array(json_writer *writer);
+bool json_writer_key(json_writer *writer, const wchar_t *key);
+bool json_writer_null(json_writer *writer);
+bool json_writer_boolean(json_writer *writer, bool boolean);
+bool json_writer_integer(json_writer *writer, json_integer integer);
+bool json_writer_floating(json_writer *writer, json_floating floating);
+bool json_writer_string(json_writer *writer, const wchar_t *string);
+bool json_writer_value(json_writer *writer, json_value value);
+
+bool json_writer_flush(json_writer *writer);
+const char *json_writer_buffer(json_writer *writer, size_t *length);
+json_error_type json_writer_error(json_writer *writer);
+
+#endif /* !JSON_WRITER_PUBLIC_H */
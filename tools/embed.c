@@ -0,0 +1,312 @@
+/*
+embed.c - jsonparse
+Modified 2026-10-19
+
+jsonparse-embed: compile a JSON file into static C data.
+
+Usage: jsonparse-embed [--packed] <input.json> <output-stem> <name>
+Writes <output-stem>.h, which declares `extern const json_value <name>;`, and
+<output-stem>.c, which defines it together with everything it refers to as
+const data. The value has the layout of a parsed document and is read through
+the same accessors, but it must never be freed, modified or frozen;
+json_value_clone yields a mutable copy. With --packed, arrays of only integers
+or only floating-point numbers are stored packed, as with
+JSON_PARSE_PACKED_ARRAYS.
+*/
+
+#include <ctype.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+#include "jsonparse.h"
+
+/* Prefix of every generated symbol. */
+static const char *name = NULL;
+
+/* Number of the next definition. */
+static size_t definition_count = 0;
+
+/*
+*** Helpers.
+*/
+
+static void fail(const char *message)
+{
+  fprintf(stderr, "jsonparse-embed: %s\n", message);
+  exit(EXIT_FAILURE);
+}
+
+static void *allocate(size_t size)
+{
+  void *memory = calloc(1, size > 0 ? size : 1);
+  if (memory == NULL)
+    fail("Out of memory.");
+  return memory;
+}
+
+static bool is_identifier(const char *identifier)
+{
+  if (!isalpha((unsigned char)*identifier) && *identifier != '_')
+    return false;
+  for (; *identifier != '\0'; identifier++)
+    if (!isalnum((unsigned char)*identifier) && *identifier != '_')
+      return false;
+  return true;
+}
+
+/*
+Write a wide string literal. Hexadecimal escapes end the literal when a hex
+digit follows, since they would swallow it.
+*/
+static void write_string(FILE *out, const wchar_t *string)
+{
+  fputs("L\"", out);
+  bool escaped = false;
+  for (; *string != L'\0'; string++) {
+    wchar_t wc = *string;
+    if (escaped && wc < 0x80 && isxdigit((int)wc))
+      fputs("\" L\"", out);
+    escaped = false;
+    if (wc == L'"' || wc == L'\\' || wc == L'?') {
+      fprintf(out, "\\%c", (char)wc);
+    } else if (wc >= 0x20 && wc < 0x7f) {
+      fputc((char)wc, out);
+    } else {
+      fprintf(out, "\\x%lx", (unsigned long)wc);
+      escaped = true;
+    }
+  }
+  fputs("\"", out);
+}
+
+static void write_floating(FILE *out, json_floating floating)
+{
+  /* 17 significant digits round-trip a double. */
+  char text[32];
+  snprintf(text, sizeof(text), "%.17g", floating);
+  fputs(text, out);
+  if (strspn(text, "-0123456789") == strlen(text))
+    fputs(".0", out);
+}
+
+/*
+*** Generation.
+
+Definitions are written depth first, so everything a definition refers to is
+defined before it.
+*/
+
+static void write_value(FILE *out, json_value value, size_t definition);
+
+/*
+Define the data a value refers to, and return its number.
+*/
+static size_t define(FILE *out, json_value value)
+{
+  switch (value.type) {
+    case JSON_TYPE_NULL:
+    case JSON_TYPE_BOOLEAN:
+    case JSON_TYPE_INTEGER:
+    case JSON_TYPE_FLOATING:
+      return 0;
+    case JSON_TYPE_STRING: {
+      size_t definition = definition_count++;
+      fprintf(out, "static const wchar_t %s_%zu[] = ", name, definition);
+      write_string(out, value.as.string);
+      fputs(";\n", out);
+      return definition;
+    }
+    case JSON_TYPE_INTEGER_ARRAY:
+    case JSON_TYPE_FLOATING_ARRAY: {
+      if (value.as.packed.count == 0)
+        return 0;
+      size_t definition = definition_count++;
+      bool integers = value.type == JSON_TYPE_INTEGER_ARRAY;
+      fprintf(out, "static const %s %s_%zu[] = {\n", integers ? "json_integer" : "json_floating", name, definition);
+      for (size_t i=0; i<value.as.packed.count; i++) {
+        fputs("  ", out);
+        if (integers) {
+          json_integer integer = ((const json_integer*)value.as.packed.items)[i];
+          if (integer == INT64_MIN)
+            fputs("INT64_MIN", out);
+          else
+            fprintf(out, "INT64_C(%" PRId64 ")", integer);
+        } else {
+          write_floating(out, ((const json_floating*)value.as.packed.items)[i]);
+        }
+        fputs(",\n", out);
+      }
+      fputs("};\n", out);
+      return definition;
+    }
+    case JSON_TYPE_ARRAY: {
+      size_t count = (size_t)value.as.array[0].as.integer;
+      size_t *definitions = allocate(count*sizeof(*definitions));
+      for (size_t i=0; i<count; i++)
+        definitions[i] = define(out, value.as.array[i+1]);
+      size_t definition = definition_count++;
+      fprintf(out, "static const json_value %s_%zu[] = {\n", name, definition);
+      fprintf(out, "  { .type = JSON_TYPE_SIZE, .as.integer = %zu },\n", count);
+      for (size_t i=0; i<count; i++) {
+        fputs("  ", out);
+        write_value(out, value.as.array[i+1], definitions[i]);
+        fputs(",\n", out);
+      }
+      fputs("};\n", out);
+      free(definitions);
+      return definition;
+    }
+    case JSON_TYPE_OBJECT: {
+      size_t count = value.as.object.pair_count;
+      if (count == 0)
+        return 0;
+      size_t *keys = allocate(count*sizeof(*keys));
+      size_t *definitions = allocate(count*sizeof(*definitions));
+      for (size_t i=0; i<count; i++) {
+        keys[i] = define(out, (json_value){ .type = JSON_TYPE_STRING, .as.string = value.as.object.pairs[i].key });
+        definitions[i] = define(out, value.as.object.pairs[i].value);
+      }
+      size_t definition = definition_count++;
+      fprintf(out, "static const json_pair %s_%zu[] = {\n", name, definition);
+      for (size_t i=0; i<count; i++) {
+        fprintf(out, "  { (wchar_t*)%s_%zu, ", name, keys[i]);
+        write_value(out, value.as.object.pairs[i].value, definitions[i]);
+        fputs(" },\n", out);
+      }
+      fputs("};\n", out);
+      free(keys);
+      free(definitions);
+      return definition;
+    }
+    default:
+      fail("Unexpected value type.");
+      return 0;
+  }
+}
+
+/*
+Write the initializer of a value whose data was defined as definition.
+*/
+static void write_value(FILE *out, json_value value, size_t definition)
+{
+  switch (value.type) {
+    case JSON_TYPE_NULL:
+      fputs("{ .type = JSON_TYPE_NULL, .as.integer = 0 }", out);
+      break;
+    case JSON_TYPE_BOOLEAN:
+      fprintf(out, "{ .type = JSON_TYPE_BOOLEAN, .as.integer = %d }", value.as.integer != 0);
+      break;
+    case JSON_TYPE_INTEGER:
+      if (value.as.integer == INT64_MIN)
+        fputs("{ .type = JSON_TYPE_INTEGER, .as.integer = INT64_MIN }", out);
+      else
+        fprintf(out, "{ .type = JSON_TYPE_INTEGER, .as.integer = INT64_C(%" PRId64 ") }", value.as.integer);
+      break;
+    case JSON_TYPE_FLOATING:
+      fputs("{ .type = JSON_TYPE_FLOATING, .as.floating = ", out);
+      write_floating(out, value.as.floating);
+      fputs(" }", out);
+      break;
+    case JSON_TYPE_STRING:
+      fprintf(out, "{ .type = JSON_TYPE_STRING, .as.string = (wchar_t*)%s_%zu }", name, definition);
+      break;
+    case JSON_TYPE_INTEGER_ARRAY:
+    case JSON_TYPE_FLOATING_ARRAY:
+      fprintf(out, "{ .type = %s, .as.packed = { %zu, ", value.type == JSON_TYPE_INTEGER_ARRAY ? "JSON_TYPE_INTEGER_ARRAY" : "JSON_TYPE_FLOATING_ARRAY", value.as.packed.count);
+      if (value.as.packed.count == 0)
+        fputs("NULL } }", out);
+      else
+        fprintf(out, "(void*)%s_%zu } }", name, definition);
+      break;
+    case JSON_TYPE_ARRAY:
+      fprintf(out, "{ .type = JSON_TYPE_ARRAY, .as.array = (json_value*)%s_%zu }", name, definition);
+      break;
+    case JSON_TYPE_OBJECT:
+      fprintf(out, "{ .type = JSON_TYPE_OBJECT, .as.object = { %zu, ", value.as.object.pair_count);
+      if (value.as.object.pair_count == 0)
+        fputs("NULL } }", out);
+      else
+        fprintf(out, "(json_pair*)%s_%zu } }", name, definition);
+      break;
+    default:
+      fail("Unexpected value type.");
+  }
+}
+
+/*
+*** Main.
+*/
+
+int main(int argc, char *argv[])
+{
+  json_parse_flags flags = JSON_PARSE_DEFAULT;
+  int argument = 1;
+  if (argc == 5 && strcmp(argv[1], "--packed") == 0) {
+    flags |= JSON_PARSE_PACKED_ARRAYS;
+    argument++;
+  }
+  if (argc-argument != 3) {
+    fprintf(stderr, "Usage: %s [--packed] <input.json> <output-stem> <name>\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+  const char *input = argv[argument];
+  const char *stem = argv[argument+1];
+  name = argv[argument+2];
+  if (!is_identifier(name))
+    fail("The name must be a C identifier.");
+
+  /* Read input. */
+  FILE *stream = fopen(input, "r");
+  json_value value = json_parse_stream_flags(stream, flags);
+  if (stream != NULL)
+    fclose(stream);
+  if (value.type == JSON_TYPE_ERROR) {
+    json_print_error(value);
+    return EXIT_FAILURE;
+  }
+
+  /* Write header. */
+  const char *base = strrchr(stem, '/');
+  base = base != NULL ? base+1 : stem;
+  char *path = allocate(strlen(stem)+3);
+  char *guard = allocate(strlen(base)+3);
+  for (size_t i=0; base[i] != '\0'; i++)
+    guard[i] = isalnum((unsigned char)base[i]) ? (char)toupper((unsigned char)base[i]) : '_';
+  strcat(guard, "_H");
+
+  sprintf(path, "%s.h", stem);
+  FILE *out = fopen(path, "w");
+  if (out == NULL)
+    fail("Cannot write header.");
+  fprintf(out, "/* Generated by jsonparse-embed from %s. Do not edit. */\n\n", input);
+  fprintf(out, "#ifndef %s\n#define %s\n\n", guard, guard);
+  fprintf(out, "#include \"jsonparse.h\"\n\n");
+  fprintf(out, "/* Read-only: never free, modify or freeze. */\n");
+  fprintf(out, "extern const json_value %s;\n\n", name);
+  fprintf(out, "#endif /* !%s */\n", guard);
+  if (fclose(out) != 0)
+    fail("Cannot write header.");
+
+  /* Write data. */
+  sprintf(path, "%s.c", stem);
+  out = fopen(path, "w");
+  if (out == NULL)
+    fail("Cannot write source.");
+  fprintf(out, "/* Generated by jsonparse-embed from %s. Do not edit. */\n\n", input);
+  fprintf(out, "#include <stdint.h>\n#include \"%s.h\"\n\n", base);
+  fprintf(out, "/* The const data is referred to through the non-const pointers of json_value. */\n");
+  fprintf(out, "#ifdef __GNUC__\n#pragma GCC diagnostic ignored \"-Wcast-qual\"\n#endif\n\n");
+  size_t definition = define(out, value);
+  fprintf(out, "\nconst json_value %s = ", name);
+  write_value(out, value, definition);
+  fputs(";\n", out);
+  if (fclose(out) != 0)
+    fail("Cannot write source.");
+
+  json_value_free(value);
+  free(path);
+  free(guard);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,125 @@
+/*
+index.c - jsonparse
+Modified 2026-10-19
+
+jsonparse-index: build a structural index of a large JSON file, and look up
+values through it.
+
+Usage: jsonparse-index build <input.json> <output.idx> [depth]
+       jsonparse-index get <input.json> <input.idx> <pointer>...
+build indexes every value down to depth (default 2). get prints the value at
+each JSON Pointer, such as /items/1024/name, on a line of its own.
+*/
+
+#include <locale.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <wchar.h>
+#include "jsonparse.h"
+
+/* Constants. */
+#define DEPTH_DEFAULT 2
+
+static int build(int argc, char *argv[])
+{
+  size_t depth = DEPTH_DEFAULT;
+  if (argc == 5) {
+    char *end;
+    depth = (size_t)strtoul(argv[4], &end, 10);
+    if (*argv[4] == '\0' || *end != '\0') {
+      fprintf(stderr, "jsonparse-index: Malformed depth: %s\n", argv[4]);
+      return EXIT_FAILURE;
+    }
+  }
+  
+  FILE *input = fopen(argv[2], "rb");
+  if (input == NULL) {
+    fprintf(stderr, "jsonparse-index: Cannot read %s\n", argv[2]);
+    return EXIT_FAILURE;
+  }
+  FILE *output = fopen(argv[3], "wb");
+  if (output == NULL) {
+    fclose(input);
+    fprintf(stderr, "jsonparse-index: Cannot write %s\n", argv[3]);
+    return EXIT_FAILURE;
+  }
+  json_error_type error = json_index_build(input, output, depth);
+  fclose(input);
+  if (fclose(output) != 0 && error == JSON_ERROR_none_)
+    error = JSON_ERROR_WRITE;
+  if (error != JSON_ERROR_none_) {
+    remove(argv[3]);
+    json_print_error((json_value){ .type = JSON_TYPE_ERROR, .as.integer = error });
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
+
+static int get(int argc, char *argv[])
+{
+  json_index *index;
+  json_error_type error = json_index_open(argv[2], argv[3], &index);
+  if (error != JSON_ERROR_none_) {
+    json_print_error((json_value){ .type = JSON_TYPE_ERROR, .as.integer = error });
+    return EXIT_FAILURE;
+  }
+  int status = EXIT_SUCCESS;
+  for (int i=4; i<argc; i++) {
+    /* Pointers are given in the locale's encoding. */
+    size_t length = mbstowcs(NULL, argv[i], 0);
+    if (length == (size_t)-1) {
+      fprintf(stderr, "jsonparse-index: Malformed pointer: %s\n", argv[i]);
+      status = EXIT_FAILURE;
+      continue;
+    }
+    wchar_t *pointer = malloc((length+1)*sizeof(*pointer));
+    if (pointer == NULL) {
+      status = EXIT_FAILURE;
+      break;
+    }
+    mbstowcs(pointer, argv[i], length+1);
+    json_value value = json_index_lookup(index, pointer, JSON_PARSE_DEFAULT);
+    free(pointer);
+  
+    if (value.type == JSON_TYPE_ERROR) {
+      fprintf(stderr, "jsonparse-index: %s\n", argv[i]);
+      json_print_error(value);
+      status = EXIT_FAILURE;
+      continue;
+    }
+    /* A writer takes a single root, so each value gets its own. */
+    json_writer *writer = json_writer_create_fd(STDOUT_FILENO);
+    if (writer == NULL) {
+      json_value_free(value);
+      status = EXIT_FAILURE;
+      break;
+    }
+    if (!json_writer_value(writer, value) || !json_writer_flush(writer)) {
+      fprintf(stderr, "jsonparse-index: %s\n", argv[i]);
+      json_print_error((json_value){ .type = JSON_TYPE_ERROR, .as.integer = json_writer_error(writer) });
+      status = EXIT_FAILURE;
+    }
+    json_writer_destroy(writer);
+    json_value_free(value);
+    /* Bypass stdio, which json_print_error writes to as wide. */
+    if (write(STDOUT_FILENO, "\n", 1) != 1)
+      status = EXIT_FAILURE;
+  }
+  
+  json_index_close(index);
+  return status;
+}
+
+int main(int argc, char *argv[])
+{
+  setlocale(LC_CTYPE, "");
+  if (argc >= 4 && argc <= 5 && strcmp(argv[1], "build") == 0)
+    return build(argc, argv);
+  if (argc >= 5 && strcmp(argv[1], "get") == 0)
+    return get(argc, argv);
+  fprintf(stderr, "Usage: %s build <input.json> <output.idx> [depth]\n", argv[0]);
+  fprintf(stderr, "       %s get <input.json> <input.idx> <pointer>...\n", argv[0]);
+  return EXIT_FAILURE;
+}
@@ -0,0 +1,695 @@
+/*
+schema.c - jsonparse
+Modified 2026-10-19
+
+jsonparse-schema: generate C types and specialized decode/encode functions from
+a JSON Schema.
+
+Usage: jsonparse-schema <schema.json> <output-stem>
+Writes <output-stem>.h and <output-stem>.c.
+
+Supported subset: "type" of "object" (with "properties", "required" and an
+optional "title"), "array" (with "items" of any non-array type), "string",
+"integer", "number" and "boolean". Everything else in the schema is ignored.
+Keys become member names with non-alphanumeric characters replaced by '_';
+keys that end up with the same name are rejected. The generated decoder
+requires the object to be the whole input.
+*/
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+#include "jsonparse.h"
+
+/*
+*** Schema model.
+*/
+
+typedef enum schema_kind_ {
+  SCHEMA_KIND_INTEGER,
+  SCHEMA_KIND_NUMBER,
+  SCHEMA_KIND_BOOLEAN,
+  SCHEMA_KIND_STRING,
+  SCHEMA_KIND_OBJECT,
+  SCHEMA_KIND_ARRAY
+} schema_kind;
+
+typedef struct schema_type_ {
+  schema_kind kind;
+  struct schema_object_ *object;
+  struct schema_type_ *items;
+} schema_type;
+
+typedef struct schema_member_ {
+  wchar_t *key;
+  char *name;
+  schema_type type;
+  bool required;
+} schema_member;
+
+typedef struct schema_object_ {
+  char *name;
+  schema_member *members;
+  size_t member_count;
+} schema_object;
+
+/* Objects in dependency order: nested objects precede their parents. */
+static schema_object **objects = NULL;
+static size_t object_count = 0;
+
+/* Scalar helpers needed by the generated code. */
+static bool uses[SCHEMA_KIND_ARRAY+1];
+
+/*
+*** Helpers.
+*/
+
+static void fail(const char *message, const wchar_t *detail)
+{
+  if (detail != NULL)
+    fprintf(stderr, "jsonparse-schema: %s: %ls\n", message, detail);
+  else
+    fprintf(stderr, "jsonparse-schema: %s\n", message);
+  exit(EXIT_FAILURE);
+}
+
+static void *allocate(size_t size)
+{
+  void *memory = calloc(1, size > 0 ? size : 1);
+  if (memory == NULL)
+    fail("Out of memory.", NULL);
+  return memory;
+}
+
+static json_value *find(json_value object, const wchar_t *key)
+{
+  object = json_value_deref(object);
+  if (object.type != JSON_TYPE_OBJECT)
+    return NULL;
+  for (size_t i=0; i<object.as.object.pair_count; i++)
+    if (wcscmp(object.as.object.pairs[i].key, key) == 0)
+      return &object.as.object.pairs[i].value;
+  return NULL;
+}
+
+static const wchar_t *find_string(json_value object, const wchar_t *key)
+{
+  json_value *value = find(object, key);
+  if (value == NULL || value->type != JSON_TYPE_STRING)
+    return NULL;
+  return value->as.string;
+}
+
+/*
+Turn a key into a C identifier.
+*/
+static char *identifier(const char *prefix, const wchar_t *key)
+{
+  static const char *keywords[] = {
+    "auto", "bool", "break", "case", "char", "const", "continue", "default", "do",
+    "double", "else", "enum", "extern", "float", "for", "goto", "if", "inline",
+    "int", "long", "register", "restrict", "return", "short", "signed", "sizeof",
+    "static", "struct", "switch", "typedef", "union", "unsigned", "void",
+    "volatile", "while", "true", "false"
+  };
+  size_t prefix_length = prefix != NULL ? strlen(prefix)+1 : 0;
+  size_t key_length = wcslen(key);
+  char *name = allocate(prefix_length+key_length+3);
+  size_t idx = 0;
+  if (prefix != NULL) {
+    memcpy(name, prefix, prefix_length-1);
+    idx = prefix_length-1;
+    name[idx++] = '_';
+  }
+  if (prefix == NULL && (key_length == 0 || (key[0] >= L'0' && key[0] <= L'9')))
+    name[idx++] = '_';
+  for (size_t i=0; i<key_length; i++)
+    name[idx++] = key[i] < 0x80 && isalnum((int)key[i]) ? (char)key[i] : '_';
+  name[idx] = '\0';
+  for (size_t i=0; i<sizeof(keywords)/sizeof(*keywords); i++)
+    if (strcmp(name, keywords[i]) == 0)
+      name[idx++] = '_';
+  return name;
+}
+
+/*
+Print a wide string literal.
+*/
+static void print_literal(FILE *out, const wchar_t *string)
+{
+  fputs("L\"", out);
+  for (; *string != L'\0'; string++) {
+    unsigned long code_point = (unsigned long)*string;
+    if (code_point >= 0x20 && code_point < 0x7f && code_point != '"' && code_point != '\\')
+      fputc((int)code_point, out);
+    else if (code_point < 0xa0)
+      fprintf(out, "\\%03lo", code_point);
+    else if (code_point < 0x10000)
+      fprintf(out, "\\u%04lx", code_point);
+    else
+      fprintf(out, "\\U%08lx", code_point);
+  }
+  fputc('"', out);
+}
+
+/*
+*** Reading the schema.
+*/
+
+static schema_object *read_object(json_value schema, char *name);
+
+static schema_type read_type(json_value schema, const char *name, bool item)
+{
+  const wchar_t *type = find_string(schema, L"type");
+  if (type == NULL)
+    fail("Missing \"type\" in schema.", NULL);
+  schema_type result = {
+    .kind = SCHEMA_KIND_INTEGER,
+    .object = NULL,
+    .items = NULL
+  };
+  if (wcscmp(type, L"integer") == 0) {
+    result.kind = SCHEMA_KIND_INTEGER;
+  } else if (wcscmp(type, L"number") == 0) {
+    result.kind = SCHEMA_KIND_NUMBER;
+  } else if (wcscmp(type, L"boolean") == 0) {
+    result.kind = SCHEMA_KIND_BOOLEAN;
+  } else if (wcscmp(type, L"string") == 0) {
+    result.kind = SCHEMA_KIND_STRING;
+  } else if (wcscmp(type, L"object") == 0) {
+    result.kind = SCHEMA_KIND_OBJECT;
+    const wchar_t *title = find_string(schema, L"title");
+    result.object = read_object(schema, title != NULL ? identifier(NULL, title) : strcpy(allocate(strlen(name)+1), name));
+  } else if (wcscmp(type, L"array") == 0) {
+    if (item)
+      fail("Arrays of arrays are not supported.", NULL);
+    json_value *items = find(schema, L"items");
+    if (items == NULL)
+      fail("Missing \"items\" in array schema.", NULL);
+    result.kind = SCHEMA_KIND_ARRAY;
+    result.items = allocate(sizeof(*result.items));
+    *result.items = read_type(*items, name, true);
+  } else {
+    fail("Unsupported type", type);
+  }
+  uses[result.kind] = true;
+  return result;
+}
+
+static schema_object *read_object(json_value schema, char *name)
+{
+  schema_object *object = allocate(sizeof(*object));
+  object->name = name;
+
+  json_value *properties = find(schema, L"properties");
+  json_value *required = find(schema, L"required");
+  if (properties != NULL) {
+    json_value list = json_value_deref(*properties);
+    if (list.type != JSON_TYPE_OBJECT)
+      fail("\"properties\" must be an object.", NULL);
+    object->member_count = list.as.object.pair_count;
+    object->members = allocate(object->member_count*sizeof(*object->members));
+    for (size_t i=0; i<object->member_count; i++) {
+      schema_member *member = &object->members[i];
+      member->key = list.as.object.pairs[i].key;
+      member->name = identifier(NULL, member->key);
+      char *nested = identifier(name, member->key);
+      member->type = read_type(list.as.object.pairs[i].value, nested, false);
+      /* Required members are listed by key. */
+      if (required != NULL) {
+        json_value names = json_value_deref(*required);
+        for (json_integer j=1; names.type == JSON_TYPE_ARRAY && j<=names.as.array[0].as.integer; j++)
+          if (names.as.array[j].type == JSON_TYPE_STRING && wcscmp(names.as.array[j].as.string, member->key) == 0)
+            member->required = true;
+      }
+    }
+  }
+
+  /* Distinct keys can map to the same identifier, e.g. "a-b" and "a_b". */
+  for (size_t i=0; i<object->member_count; i++) {
+    schema_member *member = &object->members[i];
+    for (size_t j=0; j<object->member_count; j++) {
+      schema_member *other = &object->members[j];
+      bool presence = !other->required && strncmp(member->name, "has_", 4) == 0 && strcmp(member->name+4, other->name) == 0;
+      if ((j < i && strcmp(member->name, other->name) == 0) || presence)
+        fail("Property name collides with another as a C identifier", member->key);
+    }
+  }
+  for (size_t i=0; i<object_count; i++)
+    if (strcmp(objects[i]->name, name) == 0) {
+      fprintf(stderr, "jsonparse-schema: Object type name collides with another: %s\n", name);
+      exit(EXIT_FAILURE);
+    }
+
+  /* Record after nested objects. */
+  schema_object **objects_new = realloc(objects, (object_count+1)*sizeof(*objects));
+  if (objects_new == NULL)
+    fail("Out of memory.", NULL);
+  objects = objects_new;
+  objects[object_count++] = object;
+  return object;
+}
+
+/*
+*** Generating the header.
+*/
+
+static void print_c_type(FILE *out, schema_type type)
+{
+  switch (type.kind) {
+    case SCHEMA_KIND_INTEGER:
+      fputs("json_integer", out);
+      break;
+    case SCHEMA_KIND_NUMBER:
+      fputs("json_floating", out);
+      break;
+    case SCHEMA_KIND_BOOLEAN:
+      fputs("bool", out);
+      break;
+    case SCHEMA_KIND_STRING:
+      fputs("wchar_t *", out);
+      break;
+    case SCHEMA_KIND_OBJECT:
+      fprintf(out, "%s", type.object->name);
+      break;
+    case SCHEMA_KIND_ARRAY:
+      fputs("struct {\n    ", out);
+      print_c_type(out, *type.items);
+      fputs(type.items->kind == SCHEMA_KIND_STRING ? "*items;\n" : " *items;\n", out);
+      fputs("    size_t count;\n  }", out);
+      break;
+  }
+}
+
+static void generate_header(FILE *out, const char *guard, const char *root)
+{
+  fprintf(out, "/*\n%s.h - generated by jsonparse-schema. Do not edit.\n*/\n\n", root);
+  fprintf(out, "#ifndef %s\n#define %s\n\n", guard, guard);
+  fputs("#include <stdbool.h>\n#include <stdio.h>\n#include <wchar.h>\n#include \"jsonparse.h\"\n\n", out);
+
+  for (size_t i=0; i<object_count; i++) {
+    schema_object *object = objects[i];
+    fprintf(out, "typedef struct %s_ {\n", object->name);
+    for (size_t j=0; j<object->member_count; j++) {
+      schema_member *member = &object->members[j];
+      fputs("  ", out);
+      print_c_type(out, member->type);
+      fprintf(out, member->type.kind == SCHEMA_KIND_STRING ? "%s;\n" : " %s;\n", member->name);
+      if (!member->required)
+        fprintf(out, "  bool has_%s;\n", member->name);
+    }
+    if (object->member_count == 0)
+      fputs("  char empty_;\n", out);
+    fprintf(out, "} %s;\n\n", object->name);
+  }
+
+  fprintf(out, "json_error_type %s_decode(FILE *stream, %s *dest);\n", root, root);
+  fprintf(out, "bool %s_encode(json_writer *writer, const %s *value);\n", root, root);
+  fprintf(out, "void %s_free(%s *value);\n\n", root, root);
+  fprintf(out, "#endif /* !%s */\n", guard);
+}
+
+/*
+*** Generating the implementation.
+*/
+
+static const char *scalar_names[] = {
+  "integer",
+  "number",
+  "boolean",
+  "string"
+};
+
+static void print_release(FILE *out, schema_type type, const char *lvalue, int depth)
+{
+  switch (type.kind) {
+    case SCHEMA_KIND_STRING:
+      fprintf(out, "%*sfree(%s);\n", depth, "", lvalue);
+      break;
+    case SCHEMA_KIND_OBJECT:
+      fprintf(out, "%*s%s_release(&%s);\n", depth, "", type.object->name, lvalue);
+      break;
+    case SCHEMA_KIND_ARRAY:
+      if (type.items->kind == SCHEMA_KIND_STRING || type.items->kind == SCHEMA_KIND_OBJECT) {
+        char item[512];
+        snprintf(item, sizeof(item), "%s.items[i]", lvalue);
+        fprintf(out, "%*sfor (size_t i=0; i<%s.count; i++)\n", depth, "", lvalue);
+        print_release(out, *type.items, item, depth+2);
+      }
+      fprintf(out, "%*sfree(%s.items);\n", depth, "", lvalue);
+      break;
+    default:
+      break;
+  }
+}
+
+static void print_decode(FILE *out, schema_type type, const char *lvalue, int depth)
+{
+  if (type.kind == SCHEMA_KIND_OBJECT) {
+    fprintf(out, "%*sif (!%s_decode_object(ps, &%s))\n%*sreturn false;\n", depth, "", type.object->name, lvalue, depth+2, "");
+    return;
+  }
+  if (type.kind != SCHEMA_KIND_ARRAY) {
+    fprintf(out, "%*sif (!schema_%s(ps, &%s))\n%*sreturn false;\n", depth, "", scalar_names[type.kind], lvalue, depth+2, "");
+    return;
+  }
+
+  /* Arrays grow geometrically; items are counted before decoding so a
+     partially decoded item is released on failure. */
+  char item[512];
+  snprintf(item, sizeof(item), "%s.items[%s.count-1]", lvalue, lvalue);
+  fprintf(out, "%*sif (!schema_begin(ps, L'[', JSON_ERROR_ARRAYOPEN))\n%*sreturn false;\n", depth, "", depth+2, "");
+  fprintf(out, "%*sfor (size_t capacity=0; ps->wc != L']';) {\n", depth, "");
+  fprintf(out, "%*sif (%s.count == capacity) {\n", depth+2, "", lvalue);
+  fprintf(out, "%*scapacity = capacity > 0 ? 2*capacity : 16;\n", depth+4, "");
+  fprintf(out, "%*svoid *items = realloc(%s.items, capacity*sizeof(*%s.items));\n", depth+4, "", lvalue, lvalue);
+  fprintf(out, "%*sif (items == NULL)\n%*sreturn schema_fail(ps, JSON_ERROR_MEMORY);\n", depth+4, "", depth+6, "");
+  fprintf(out, "%*s%s.items = items;\n", depth+4, "", lvalue);
+  fprintf(out, "%*s}\n", depth+2, "");
+  fprintf(out, "%*smemset(&%s.items[%s.count++], 0, sizeof(*%s.items));\n", depth+2, "", lvalue, lvalue, lvalue);
+  print_decode(out, *type.items, item, depth+2);
+  fprintf(out, "%*sif (!schema_next(ps))\n%*sbreak;\n", depth+2, "", depth+4, "");
+  fprintf(out, "%*s}\n", depth, "");
+  fprintf(out, "%*sif (!json_parse_character(ps, L']'))\n%*sreturn schema_fail(ps, JSON_ERROR_ARRAYCLOSE);\n", depth, "", depth+2, "");
+}
+
+static void print_encode(FILE *out, schema_type type, const char *rvalue, int depth)
+{
+  switch (type.kind) {
+    case SCHEMA_KIND_INTEGER:
+      fprintf(out, "%*sif (!json_writer_integer(writer, %s))\n", depth, "", rvalue);
+      break;
+    case SCHEMA_KIND_NUMBER:
+      fprintf(out, "%*sif (!json_writer_floating(writer, %s))\n", depth, "", rvalue);
+      break;
+    case SCHEMA_KIND_BOOLEAN:
+      fprintf(out, "%*sif (!json_writer_boolean(writer, %s))\n", depth, "", rvalue);
+      break;
+    case SCHEMA_KIND_STRING:
+      fprintf(out, "%*sif (%s == NULL ? !json_writer_null(writer) : !json_writer_string(writer, %s))\n", depth, "", rvalue, rvalue);
+      break;
+    case SCHEMA_KIND_OBJECT:
+      fprintf(out, "%*sif (!%s_encode_object(writer, &%s))\n", depth, "", type.object->name, rvalue);
+      break;
+    case SCHEMA_KIND_ARRAY: {
+      char item[512];
+      snprintf(item, sizeof(item), "%s.items[i]", rvalue);
+      fprintf(out, "%*sif (!json_writer_begin_array(writer))\n%*sreturn false;\n", depth, "", depth+2, "");
+      fprintf(out, "%*sfor (size_t i=0; i<%s.count; i++)\n", depth, "", rvalue);
+      print_encode(out, *type.items, item, depth+2);
+      fprintf(out, "%*sif (!json_writer_end_array(writer))\n", depth, "");
+      break;
+    }
+  }
+  fprintf(out, "%*sreturn false;\n", depth+2, "");
+}
+
+static void generate_helpers(FILE *out)
+{
+  fputs(
+    "static bool schema_fail(json_parser_state *ps, json_error_type error)\n"
+    "{\n"
+    "  if (ps->error == JSON_ERROR_none_)\n"
+    "    ps->error = error;\n"
+    "  return false;\n"
+    "}\n\n"
+    "static bool schema_begin(json_parser_state *ps, wchar_t open, json_error_type error)\n"
+    "{\n"
+    "  json_parse_whitespace(ps);\n"
+    "  if (!json_parse_character(ps, open))\n"
+    "    return schema_fail(ps, ps->wc == WEOF ? error : JSON_ERROR_SCHEMA);\n"
+    "  json_parse_whitespace(ps);\n"
+    "  return true;\n"
+    "}\n\n"
+    "static bool schema_next(json_parser_state *ps)\n"
+    "{\n"
+    "  json_parse_whitespace(ps);\n"
+    "  if (!json_parse_character(ps, L','))\n"
+    "    return false;\n"
+    "  json_parse_whitespace(ps);\n"
+    "  return true;\n"
+    "}\n\n"
+    "static bool schema_skip(json_parser_state *ps)\n"
+    "{\n"
+    "  json_value value = json_parse_value(ps);\n"
+    "  if (ps->error != JSON_ERROR_none_)\n"
+    "    return false;\n"
+    "  json_value_free(value);\n"
+    "  return true;\n"
+    "}\n\n",
+    out
+  );
+  if (uses[SCHEMA_KIND_INTEGER] || uses[SCHEMA_KIND_NUMBER])
+    fputs(
+      "static bool schema_numeric(json_parser_state *ps, json_value *dest)\n"
+      "{\n"
+      "  json_parse_whitespace(ps);\n"
+      "  if (ps->wc != L'-' && (ps->wc < L'0' || ps->wc > L'9'))\n"
+      "    return schema_fail(ps, JSON_ERROR_SCHEMA);\n"
+      "  *dest = json_parse_number(ps);\n"
+      "  return ps->error == JSON_ERROR_none_;\n"
+      "}\n\n",
+      out
+    );
+  if (uses[SCHEMA_KIND_INTEGER])
+    fputs(
+      "static bool schema_integer(json_parser_state *ps, json_integer *dest)\n"
+      "{\n"
+      "  json_value value;\n"
+      "  if (!schema_numeric(ps, &value))\n"
+      "    return false;\n"
+      "  if (value.type != JSON_TYPE_INTEGER)\n"
+      "    return schema_fail(ps, JSON_ERROR_SCHEMA);\n"
+      "  *dest = value.as.integer;\n"
+      "  return true;\n"
+      "}\n\n",
+      out
+    );
+  if (uses[SCHEMA_KIND_NUMBER])
+    fputs(
+      "static bool schema_number(json_parser_state *ps, json_floating *dest)\n"
+      "{\n"
+      "  json_value value;\n"
+      "  if (!schema_numeric(ps, &value))\n"
+      "    return false;\n"
+      "  *dest = value.type == JSON_TYPE_INTEGER ? (json_floating)value.as.integer : value.as.floating;\n"
+      "  return true;\n"
+      "}\n\n",
+      out
+    );
+  if (uses[SCHEMA_KIND_BOOLEAN])
+    fputs(
+      "static bool schema_boolean(json_parser_state *ps, bool *dest)\n"
+      "{\n"
+      "  json_parse_whitespace(ps);\n"
+      "  if (ps->wc == L't') {\n"
+      "    *dest = true;\n"
+      "    return json_parse_literal(ps, L\"true\") || schema_fail(ps, JSON_ERROR_TRUE);\n"
+      "  }\n"
+      "  if (ps->wc == L'f') {\n"
+      "    *dest = false;\n"
+      "    return json_parse_literal(ps, L\"false\") || schema_fail(ps, JSON_ERROR_FALSE);\n"
+      "  }\n"
+      "  return schema_fail(ps, JSON_ERROR_SCHEMA);\n"
+      "}\n\n",
+      out
+    );
+  if (uses[SCHEMA_KIND_STRING])
+    fputs(
+      "static bool schema_string(json_parser_state *ps, wchar_t **dest)\n"
+      "{\n"
+      "  json_parse_whitespace(ps);\n"
+      "  if (ps->wc != L'\"')\n"
+      "    return schema_fail(ps, JSON_ERROR_SCHEMA);\n"
+      "  free(*dest);\n"
+      "  *dest = json_parse_string(ps);\n"
+      "  return ps->error == JSON_ERROR_none_;\n"
+      "}\n\n",
+      out
+    );
+}
+
+static void generate_object(FILE *out, schema_object *object)
+{
+  char lvalue[512];
+
+  /* Release. */
+  fprintf(out, "static void %s_release(%s *value)\n{\n", object->name, object->name);
+  for (size_t i=0; i<object->member_count; i++) {
+    snprintf(lvalue, sizeof(lvalue), "value->%s", object->members[i].name);
+    print_release(out, object->members[i].type, lvalue, 2);
+  }
+  fputs("  (void)value;\n}\n\n", out);
+
+  /* Key matching: switch on the length, then compare. */
+  fprintf(out, "static int %s_member(const wchar_t *key)\n{\n  switch (wcslen(key)) {\n", object->name);
+  for (size_t i=0; i<object->member_count; i++) {
+    size_t length = wcslen(object->members[i].key);
+    bool first = true;
+    for (size_t j=0; j<i; j++)
+      if (wcslen(object->members[j].key) == length)
+        first = false;
+    if (!first)
+      continue;
+    fprintf(out, "    case %zu:\n", length);
+    for (size_t j=i; j<object->member_count; j++) {
+      if (wcslen(object->members[j].key) != length)
+        continue;
+      fputs("      if (wcscmp(key, ", out);
+      print_literal(out, object->members[j].key);
+      fprintf(out, ") == 0)\n        return %zu;\n", j);
+    }
+    fputs("      break;\n", out);
+  }
+  fputs("    default:\n      break;\n  }\n  return -1;\n}\n\n", out);
+
+  /* Decode. */
+  fprintf(out, "static bool %s_decode_object(json_parser_state *ps, %s *dest)\n{\n", object->name, object->name);
+  fprintf(out, "  bool seen[%zu] = { false };\n", object->member_count > 0 ? object->member_count : 1);
+  fputs("  if (!schema_begin(ps, L'{', JSON_ERROR_OBJECTOPEN))\n    return false;\n", out);
+  fputs("  while (ps->wc != L'}') {\n", out);
+  fputs("    wchar_t *key = json_parse_string(ps);\n    if (key == NULL)\n      return false;\n", out);
+  fprintf(out, "    int member = %s_member(key);\n    free(key);\n", object->name);
+  fputs("    json_parse_whitespace(ps);\n", out);
+  fputs("    if (!json_parse_character(ps, L':'))\n      return schema_fail(ps, JSON_ERROR_PAIRSEPERATOR);\n", out);
+  fputs("    switch (member) {\n", out);
+  for (size_t i=0; i<object->member_count; i++) {
+    schema_member *member = &object->members[i];
+    fprintf(out, "      case %zu:\n", i);
+    snprintf(lvalue, sizeof(lvalue), "dest->%s", member->name);
+    if (member->type.kind == SCHEMA_KIND_ARRAY || member->type.kind == SCHEMA_KIND_OBJECT) {
+      /* Repeated keys replace earlier values. */
+      print_release(out, member->type, lvalue, 8);
+      fprintf(out, "        memset(&%s, 0, sizeof(%s));\n", lvalue, lvalue);
+    }
+    print_decode(out, member->type, lvalue, 8);
+    if (!member->required)
+      fprintf(out, "        dest->has_%s = true;\n", member->name);
+    fputs("        break;\n", out);
+  }
+  fputs("      default:\n        if (!schema_skip(ps))\n          return false;\n        break;\n    }\n", out);
+  fputs("    if (member >= 0)\n      seen[member] = true;\n", out);
+  fputs("    if (!schema_next(ps))\n      break;\n  }\n", out);
+  fputs("  if (!json_parse_character(ps, L'}'))\n    return schema_fail(ps, JSON_ERROR_OBJECTCLOSE);\n", out);
+  for (size_t i=0; i<object->member_count; i++)
+    if (object->members[i].required)
+      fprintf(out, "  if (!seen[%zu])\n    return schema_fail(ps, JSON_ERROR_SCHEMA);\n", i);
+  fputs("  (void)seen;\n  return true;\n}\n\n", out);
+
+  /* Encode. */
+  fprintf(out, "static bool %s_encode_object(json_writer *writer, const %s *value)\n{\n", object->name, object->name);
+  fputs("  if (!json_writer_begin_object(writer))\n    return false;\n", out);
+  for (size_t i=0; i<object->member_count; i++) {
+    schema_member *member = &object->members[i];
+    snprintf(lvalue, sizeof(lvalue), "value->%s", member->name);
+    int depth = 2;
+    if (!member->required) {
+      fprintf(out, "  if (value->has_%s) {\n", member->name);
+      depth = 4;
+    }
+    fprintf(out, "%*sif (!json_writer_key(writer, ", depth, "");
+    print_literal(out, member->key);
+    fprintf(out, "))\n%*sreturn false;\n", depth+2, "");
+    print_encode(out, member->type, lvalue, depth);
+    if (!member->required)
+      fputs("  }\n", out);
+  }
+  fputs("  return json_writer_end_object(writer);\n}\n\n", out);
+}
+
+static void generate_source(FILE *out, const char *header, const char *root)
+{
+  fprintf(out, "/*\n%s.c - generated by jsonparse-schema. Do not edit.\n*/\n\n", root);
+  fprintf(out, "#include \"%s\"\n#include \"parser.h\"\n#include \"source.h\"\n#include <string.h>\n\n", header);
+  generate_helpers(out);
+  for (size_t i=0; i<object_count; i++)
+    generate_object(out, objects[i]);
+
+  fprintf(out, "json_error_type %s_decode(FILE *stream, %s *dest)\n{\n", root, root);
+  fputs("  memset(dest, 0, sizeof(*dest));\n  if (stream == NULL)\n    return JSON_ERROR_FILE;\n", out);
+  fputs("  json_source *source = json_source_create_file(stream);\n  if (source == NULL)\n    return JSON_ERROR_MEMORY;\n", out);
+  fputs("  json_parser_state *ps = json_parser_create(source, JSON_PARSE_DEFAULT);\n", out);
+  fputs("  if (ps == NULL) {\n    json_source_destroy(source);\n    return JSON_ERROR_MEMORY;\n  }\n", out);
+  fprintf(out, "  if (%s_decode_object(ps, dest)) {\n", root);
+  fputs("    json_parse_whitespace(ps);\n    if (ps->wc != WEOF)\n      schema_fail(ps, JSON_ERROR_TRAILING);\n  }\n", out);
+  fputs("  json_error_type error = json_parser_error(ps);\n  json_parser_destroy(ps);\n  json_source_destroy(source);\n", out);
+  fprintf(out, "  if (error != JSON_ERROR_none_)\n    %s_free(dest);\n  return error;\n}\n\n", root);
+
+  fprintf(out, "bool %s_encode(json_writer *writer, const %s *value)\n{\n", root, root);
+  fprintf(out, "  return %s_encode_object(writer, value);\n}\n\n", root);
+
+  fprintf(out, "void %s_free(%s *value)\n{\n", root, root);
+  fprintf(out, "  %s_release(value);\n  memset(value, 0, sizeof(*value));\n}\n", root);
+}
+
+/*
+*** Main.
+*/
+
+int main(int argc, char *argv[])
+{
+  if (argc != 3) {
+    fprintf(stderr, "Usage: %s <schema.json> <output-stem>\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  /* Read schema. */
+  FILE *stream = fopen(argv[1], "r");
+  json_value schema = json_parse_stream(stream);
+  if (stream != NULL)
+    fclose(stream);
+  if (schema.type == JSON_TYPE_ERROR) {
+    json_print_error(schema);
+    return EXIT_FAILURE;
+  }
+
+  /* Name the root type after its title or the output file. */
+  const char *stem = argv[2];
+  const char *base = strrchr(stem, '/');
+  base = base != NULL ? base+1 : stem;
+  const wchar_t *title = find_string(schema, L"title");
+  char *root;
+  if (title != NULL) {
+    root = identifier(NULL, title);
+  } else {
+    wchar_t *wide = allocate((strlen(base)+1)*sizeof(*wide));
+    for (size_t i=0; base[i] != '\0'; i++)
+      wide[i] = (wchar_t)(unsigned char)base[i];
+    root = identifier(NULL, wide);
+  }
+  const wchar_t *type = find_string(schema, L"type");
+  if (type == NULL || wcscmp(type, L"object") != 0)
+    fail("The root schema must describe an object.", NULL);
+  uses[SCHEMA_KIND_OBJECT] = true;
+  read_object(schema, root);
+
+  /* Write header and implementation. */
+  size_t stem_length = strlen(stem);
+  char *path = allocate(stem_length+3);
+  char *guard = allocate(strlen(base)+3);
+  for (size_t i=0; base[i] != '\0'; i++)
+    guard[i] = isalnum((unsigned char)base[i]) ? (char)toupper((unsigned char)base[i]) : '_';
+  strcat(guard, "_H");
+  char *header = allocate(strlen(base)+3);
+  sprintf(header, "%s.h", base);
+
+  sprintf(path, "%s.h", stem);
+  FILE *out = fopen(path, "w");
+  if (out == NULL)
+    fail("Cannot write header.", NULL);
+  generate_header(out, guard, root);
+  fclose(out);
+
+  sprintf(path, "%s.c", stem);
+  out = fopen(path, "w");
+  if (out == NULL)
+    fail("Cannot write source.", NULL);
+  generate_source(out, header, root);
+  fclose(out);
+
+  /* The process ends here; the schema model is left to the system. */
+  json_value_free(schema);
+  return EXIT_SUCCESS;
+}